@@ -0,0 +1,84 @@
+/* arena.c
+ *
+ * In this file a bump allocator is defined. The scanner uses it to put all nodes and
+ * identifier strings of the token list of one input line in a single region, which is
+ * released with one call of resetArena instead of one free per node.
+ */
+
+#include <stdlib.h> /* NULL, malloc, free */
+#include <assert.h> /* assert */
+#include "arena.h"
+
+/* Allocations are aligned on the size of the largest member of this union. */
+
+typedef union ArenaAlign {
+  void *p;
+  double d;
+  long l;
+} ArenaAlign;
+
+#define ALIGNMENT sizeof(ArenaAlign)
+#define ALIGNUP(n) (((n) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT)
+#define HEADER ALIGNUP(sizeof(ArenaBlock))
+
+void initArena(Arena *a) {
+  a->top = NULL;
+}
+
+/* The function newBlock adds a block of at least n usable bytes on top of the arena.
+ * The blocks grow geometrically, so a long line needs only a few of them.
+ */
+
+static void newBlock(Arena *a, size_t n) {
+  size_t size = (a->top == NULL ? ARENABLOCK : 2 * a->top->size);
+  ArenaBlock *b;
+  while (size < n) {
+    size = 2 * size;
+  }
+  b = malloc(HEADER + size);
+  assert(b != NULL);
+  b->prev = a->top;
+  b->size = size;
+  b->used = 0;
+  a->top = b;
+}
+
+/* The function arenaAlloc yields n bytes of suitably aligned memory from the arena.
+ */
+
+void *arenaAlloc(Arena *a, size_t n) {
+  void *p;
+  n = ALIGNUP(n);
+  if (a->top == NULL || a->top->size - a->top->used < n) {
+    newBlock(a, n);
+  }
+  p = (char *)a->top + HEADER + a->top->used;
+  a->top->used += n;
+  return p;
+}
+
+/* The function resetArena releases everything that has been allocated in the arena.
+ * Only the top block, which is the biggest, is kept, so that an arena that is reset
+ * after every line stops calling malloc once it has seen the longest line.
+ */
+
+void resetArena(Arena *a) {
+  ArenaBlock *b;
+  if (a->top == NULL) {
+    return;
+  }
+  b = a->top->prev;
+  while (b != NULL) {
+    ArenaBlock *prev = b->prev;
+    free(b);
+    b = prev;
+  }
+  a->top->prev = NULL;
+  a->top->used = 0;
+}
+
+void freeArena(Arena *a) {
+  resetArena(a);
+  free(a->top);
+  a->top = NULL;
+}
@@ -0,0 +1,31 @@
+/* arena.h, bump allocator for the token lists of one input line */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h> /* size_t */
+
+#define ARENABLOCK 4096 /* size of the first block of an arena */
+
+/* An arena is a chain of blocks from which memory is handed out by
+ * bumping an offset. Individual allocations are never freed: the whole
+ * arena is released at once with resetArena (which keeps the biggest block
+ * for reuse) or freeArena.
+ */
+
+typedef struct ArenaBlock {
+  struct ArenaBlock *prev;
+  size_t size;
+  size_t used;
+} ArenaBlock;
+
+typedef struct Arena {
+  ArenaBlock *top;
+} Arena;
+
+void initArena(Arena *a);
+void *arenaAlloc(Arena *a, size_t n);
+void resetArena(Arena *a);
+void freeArena(Arena *a);
+
+#endif
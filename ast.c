@@ -0,0 +1,433 @@
+/* ast.c
+ *
+ * In this file a builder is defined that turns the token list of an arithmetical expression
+ * into a syntax tree, for the grammar of bytecode.c, and a compiler from the tree to a program
+ * for the stack machine of bytecode.c.
+ * The tree is optimized while it is built, in the function makeOp:
+ * - constant folding: an operator with two numbers as operands is replaced by its value;
+ * - simplification: x*1, 1*x, x/1, x-0, x+0 and 0+x are replaced by x;
+ * - common subexpressions: every subtree is made only once, so a subexpression that occurs
+ *   more than once is computed once by the compiled program and then kept in a temporary.
+ * The operands of + and * are put in a fixed order first, so a+b and b+a are the same tree.
+ * Terms are not reassociated, e.g. 1+x+2 is not folded to x+3, since for floating point
+ * numbers that can give another value. For the same reason x*0 is not simplified to 0.
+ * The only difference with the unoptimized program is that x+0 and 0+x yield x when x is -0.
+ */
+
+#include <stdlib.h> /* NULL, calloc, realloc, free */
+#include <string.h> /* memcpy, memset */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "ast.h"
+
+#define INITSLOTS 64
+
+void initAstBuilder(AstBuilder *b) {
+  initArena(&b->arena);
+  b->nslots = INITSLOTS;
+  b->slots = calloc(b->nslots, sizeof(Node *));
+  assert(b->slots != NULL);
+  b->count = 0;
+  initInternTable(&b->vars);
+  b->optimize = 1;
+  b->operands = NULL;
+  b->ops = NULL;
+  b->stackCapacity = 0;
+  b->frames = NULL;
+  b->nframes = 0;
+  b->frameCapacity = 0;
+}
+
+/* The function clearAstBuilder releases all nodes and variables, so that the next expression
+ * can be built; the memory of the builder is reused.
+ */
+
+void clearAstBuilder(AstBuilder *b) {
+  resetArena(&b->arena);
+  memset(b->slots, 0, b->nslots * sizeof(Node *));
+  b->count = 0;
+  clearInternTable(&b->vars);
+}
+
+void freeAstBuilder(AstBuilder *b) {
+  freeArena(&b->arena);
+  free(b->slots);
+  b->slots = NULL;
+  freeInternTable(&b->vars);
+  free(b->operands);
+  free(b->ops);
+  b->operands = NULL;
+  b->ops = NULL;
+  b->stackCapacity = 0;
+  free(b->frames);
+  b->frames = NULL;
+  b->frameCapacity = 0;
+}
+
+/* The function hashNode computes the hash of a node from its own fields and the hashes of its
+ * operands, and sameNode tells whether two nodes are equal. Since the operands are shared
+ * already, comparing them as pointers suffices. Numbers are compared bit by bit, so that
+ * 0 and -0 stay different nodes.
+ */
+
+static unsigned hashNode(Node *n) {
+  unsigned h = 2166136261u;
+  unsigned char bytes[sizeof(double)];
+  int i;
+  h = (h ^ n->kind) * 16777619u;
+  switch (n->kind) {
+  case NodeNum:
+    memcpy(bytes, &n->value, sizeof(double));
+    for (i = 0; i < (int)sizeof(double); i++) {
+      h = (h ^ bytes[i]) * 16777619u;
+    }
+    break;
+  case NodeVar:
+    h = (h ^ (unsigned)n->var) * 16777619u;
+    break;
+  case NodeOp:
+    h = (h ^ (unsigned char)n->op) * 16777619u;
+    h = (h ^ n->left->hash) * 16777619u;
+    h = (h ^ n->right->hash) * 16777619u;
+    break;
+  }
+  return h;
+}
+
+static int sameNode(Node *m, Node *n) {
+  if (m->kind != n->kind || m->hash != n->hash) {
+    return 0;
+  }
+  switch (m->kind) {
+  case NodeNum:
+    return memcmp(&m->value, &n->value, sizeof(double)) == 0;
+  case NodeVar:
+    return m->var == n->var;
+  default:
+    return m->op == n->op && m->left == n->left && m->right == n->right;
+  }
+}
+
+static void growSlots(AstBuilder *b) {
+  int nslots = 2 * b->nslots;
+  Node **slots = calloc(nslots, sizeof(Node *));
+  Node *n, *next;
+  int i;
+  assert(slots != NULL);
+  for (i = 0; i < b->nslots; i++) {
+    for (n = b->slots[i]; n != NULL; n = next) {
+      next = n->chain;
+      n->chain = slots[n->hash & (nslots - 1)];
+      slots[n->hash & (nslots - 1)] = n;
+    }
+  }
+  free(b->slots);
+  b->slots = slots;
+  b->nslots = nslots;
+}
+
+/* The function shareNode yields the node in the table that is equal to the node *proto,
+ * which is made in the arena and added to the table when there is none yet.
+ */
+
+static Node *shareNode(AstBuilder *b, Node *proto) {
+  Node *n;
+  int slot;
+  proto->hash = hashNode(proto);
+  proto->uses = 0;
+  proto->temp = -1;
+  slot = proto->hash & (b->nslots - 1);
+  if (b->optimize) {
+    for (n = b->slots[slot]; n != NULL; n = n->chain) {
+      if (sameNode(n, proto)) {
+        return n;
+      }
+    }
+  }
+  n = arenaAlloc(&b->arena, sizeof(Node));
+  *n = *proto;
+  n->chain = b->slots[slot];
+  b->slots[slot] = n;
+  b->count++;
+  if (b->count > b->nslots) {
+    growSlots(b);
+  }
+  return n;
+}
+
+static Node *makeNum(AstBuilder *b, double w) {
+  Node proto;
+  proto.kind = NodeNum;
+  proto.value = w;
+  return shareNode(b, &proto);
+}
+
+static Node *makeVar(AstBuilder *b, int var) {
+  Node proto;
+  proto.kind = NodeVar;
+  proto.var = var;
+  return shareNode(b, &proto);
+}
+
+static int isNum(Node *n, double w) {
+  return n->kind == NodeNum && n->value == w;
+}
+
+/* The function precedes gives the fixed order of the operands of + and *: numbers first,
+ * then variables, then operators, each group ordered by value, id or hash.
+ */
+
+static int precedes(Node *m, Node *n) {
+  if (m->kind != n->kind) {
+    return m->kind < n->kind;
+  }
+  switch (m->kind) {
+  case NodeNum:
+    return m->value < n->value;
+  case NodeVar:
+    return m->var < n->var;
+  default:
+    return m->hash < n->hash;
+  }
+}
+
+static Node *makeOp(AstBuilder *b, char op, Node *left, Node *right) {
+  Node proto;
+  Node *h;
+  if (b->optimize) {
+    if (left->kind == NodeNum && right->kind == NodeNum) {
+      switch (op) {
+      case '+':
+        return makeNum(b, left->value + right->value);
+      case '-':
+        return makeNum(b, left->value - right->value);
+      case '*':
+        return makeNum(b, left->value * right->value);
+      default:
+        return makeNum(b, left->value / right->value);
+      }
+    }
+    if (((op == '*' || op == '/') && isNum(right, 1)) ||
+        ((op == '+' || op == '-') && isNum(right, 0))) {
+      return left;
+    }
+    if ((op == '*' && isNum(left, 1)) || (op == '+' && isNum(left, 0))) {
+      return right;
+    }
+    if ((op == '+' || op == '*') && precedes(right, left)) {
+      h = left;
+      left = right;
+      right = h;
+    }
+  }
+  proto.kind = NodeOp;
+  proto.op = op;
+  proto.left = left;
+  proto.right = right;
+  return shareNode(b, &proto);
+}
+
+static void growBuildStack(AstBuilder *b) {
+  b->stackCapacity = (b->stackCapacity == 0 ? 64 : 2 * b->stackCapacity);
+  b->operands = realloc(b->operands, b->stackCapacity * sizeof(Node *));
+  b->ops = realloc(b->ops, b->stackCapacity * sizeof(char));
+  assert(b->operands != NULL && b->ops != NULL);
+}
+
+/* The function reduceNodes applies the topmost operator to the two topmost operands. */
+
+static int reduceNodes(AstBuilder *b, int noperands, int nops) {
+  Node **n = b->operands + noperands - 2;
+  n[0] = makeOp(b, b->ops[nops - 1], n[0], n[1]);
+  return noperands - 1;
+}
+
+/* The function buildExpression builds the tree of the expression at the start of the token
+ * list, for the grammar of compileExpression in bytecode.c, replacing the tree that b
+ * contained before; then the pointer points to the rest of the list. Otherwise it yields NULL.
+ * It is a shunting-yard parser like shunt in evalExp.c, with the operands and the pending
+ * operators on the stacks of the builder, so that deep parentheses do not need a deep stack of
+ * calls either. The operators are applied in the order of a recursive descent parser, so
+ * makeOp sees the same operands.
+ */
+
+Node *buildExpression(List *lp, AstBuilder *b) {
+  List l = *lp;
+  int noperands = 0, nops = 0, depth = 0;
+  int var;
+  char op;
+  clearAstBuilder(b);
+  for (;;) {
+    /* an operand: open parentheses, then a number or an identifier */
+    while (l != NULL && l->tt == Symbol && (l->t).symbol == '(') {
+      if (nops == b->stackCapacity) {
+        growBuildStack(b);
+      }
+      b->ops[nops++] = '(';
+      depth++;
+      l = l->next;
+    }
+    if (l == NULL || (l->tt != Number && l->tt != Identifier)) {
+      return NULL;
+    }
+    if (noperands == b->stackCapacity) {
+      growBuildStack(b);
+    }
+    if (l->tt == Number) {
+      b->operands[noperands++] = makeNum(b, numberValue(l));
+    } else {
+      var = internIdentifier(&b->vars, (l->t).identifier, l->length);
+      b->operands[noperands++] = makeVar(b, var);
+    }
+    l = l->next;
+    /* closing parentheses, then an operator or the end of the expression */
+    op = (l != NULL && l->tt == Symbol ? (l->t).symbol : '\0');
+    while (op == ')' && depth > 0) {
+      while (b->ops[nops - 1] != '(') {
+        noperands = reduceNodes(b, noperands, nops--);
+      }
+      nops--;
+      depth--;
+      l = l->next;
+      op = (l != NULL && l->tt == Symbol ? (l->t).symbol : '\0');
+    }
+    if (op == '*' || op == '/') {
+      while (nops > 0 && (b->ops[nops - 1] == '*' || b->ops[nops - 1] == '/')) {
+        noperands = reduceNodes(b, noperands, nops--);
+      }
+    } else if (op == '+' || op == '-') {
+      while (nops > 0 && b->ops[nops - 1] != '(') {
+        noperands = reduceNodes(b, noperands, nops--);
+      }
+    } else { /* the end of the expression; a '(' without ')' is an error */
+      if (depth > 0) {
+        return NULL;
+      }
+      while (nops > 0) {
+        noperands = reduceNodes(b, noperands, nops--);
+      }
+      *lp = l;
+      return b->operands[0];
+    }
+    if (nops == b->stackCapacity) {
+      growBuildStack(b);
+    }
+    b->ops[nops++] = op;
+    l = l->next;
+  }
+}
+
+/* The functions countUses and emitNode walk the tree with the stack frames of the builder
+ * instead of recursion, like compileSum and compileTerm loop over the operands, so that a long
+ * line such as 1+2+...+n does not need a deep stack of calls. The operands of + and * may have
+ * been swapped, so the long branch can be on either side.
+ */
+
+typedef struct Frame {
+  Node *node;
+  int state; /* 0: nothing emitted yet, 1: left operand emitted, 2: both emitted */
+} Frame;
+
+static void pushFrame(AstBuilder *b, Node *n) {
+  if (b->nframes == b->frameCapacity) {
+    b->frameCapacity = (b->frameCapacity == 0 ? 64 : 2 * b->frameCapacity);
+    b->frames = realloc(b->frames, b->frameCapacity * sizeof(Frame));
+    assert(b->frames != NULL);
+  }
+  b->frames[b->nframes].node = n;
+  b->frames[b->nframes].state = 0;
+  b->nframes++;
+}
+
+/* countUses counts the edges to every node below root, visiting the nodes below a node
+ * only the first time it is reached.
+ */
+
+static void countUses(Node *root, AstBuilder *b) {
+  Node *n;
+  pushFrame(b, root);
+  while (b->nframes > 0) {
+    n = b->frames[--b->nframes].node;
+    if (n->kind == NodeOp) {
+      if (++n->left->uses == 1) {
+        pushFrame(b, n->left);
+      }
+      if (++n->right->uses == 1) {
+        pushFrame(b, n->right);
+      }
+    }
+  }
+}
+
+/* emitNode emits the code of a node after that of its operands. A shared node is computed
+ * the first time it is reached and kept in a temporary with OpStore; after that OpTemp
+ * pushes it again.
+ */
+
+static void emitOperator(Node *n, Program *p, int *ntemps) {
+  switch (n->op) {
+  case '+':
+    emit(p, OpAdd, 0);
+    break;
+  case '-':
+    emit(p, OpSub, 0);
+    break;
+  case '*':
+    emit(p, OpMul, 0);
+    break;
+  default:
+    emit(p, OpDiv, 0);
+    break;
+  }
+  if (n->uses > 1) {
+    n->temp = (*ntemps)++;
+    emit(p, OpStore, n->temp);
+  }
+}
+
+static void emitNode(Node *root, Program *p, AstBuilder *b) {
+  Frame *f;
+  Node *n;
+  int ntemps = 0;
+  pushFrame(b, root);
+  while (b->nframes > 0) {
+    f = &b->frames[b->nframes - 1];
+    n = f->node;
+    if (n->temp >= 0) {
+      emit(p, OpTemp, n->temp);
+      b->nframes--;
+    } else if (n->kind == NodeNum) {
+      emitConst(p, n->value);
+      b->nframes--;
+    } else if (n->kind == NodeVar) {
+      emit(p, OpLoad, n->var);
+      b->nframes--;
+    } else if (f->state == 0) {
+      f->state = 1;
+      pushFrame(b, n->left);
+    } else if (f->state == 1) {
+      f->state = 2;
+      pushFrame(b, n->right);
+    } else {
+      emitOperator(n, p, &ntemps);
+      b->nframes--;
+    }
+  }
+}
+
+/* The function compileAst compiles the tree root, built by b, into the program p, replacing
+ * what p contained before. The variables of p get the same ids as in b, so p can be bound
+ * and run as when it is made with compileExpression.
+ */
+
+void compileAst(Node *root, AstBuilder *b, Program *p) {
+  int i;
+  resetProgram(p);
+  for (i = 0; i < b->vars.count; i++) {
+    internIdentifier(&p->vars, identifierName(&b->vars, i), b->vars.length[i]);
+  }
+  root->uses++;
+  countUses(root, b);
+  emitNode(root, p, b);
+  finishProgram(p);
+}
@@ -0,0 +1,64 @@
+/* ast.h, syntax trees of arithmetical expressions */
+
+#ifndef AST_H
+#define AST_H
+
+#include "scanner.h"
+#include "bytecode.h"
+
+/* A Node is a node of the syntax tree of an expression: a number with the given value, a
+ * variable with the given id, or an operator op ('+', '-', '*' or '/') applied to left and
+ * right. Equal subtrees are shared, so the tree is in fact a directed acyclic graph;
+ * uses is the number of edges that point to a node, and temp the temporary in which the
+ * value of a shared node is kept while compiling, or -1.
+ */
+
+typedef enum NodeKind {
+  NodeNum,
+  NodeVar,
+  NodeOp
+} NodeKind;
+
+typedef struct Node {
+  NodeKind kind;
+  char op;
+  int var;
+  double value;
+  struct Node *left;
+  struct Node *right;
+  unsigned hash;
+  int uses;
+  int temp;
+  struct Node *chain; /* the next node in the same slot of the table of the builder */
+} Node;
+
+/* An AstBuilder makes the nodes of one expression at a time. The nodes are allocated in the
+ * arena; the hash table slots contains every node made so far, so that equal subtrees are
+ * made only once. vars gives the variables their ids. When optimize is 0, the tree is kept
+ * as it was written: nothing is folded, simplified or shared. operands and ops are the stacks
+ * of buildExpression, with room for stackCapacity elements, and frames is the stack of the
+ * walks of compileAst over the tree; they are kept for the next expression.
+ */
+
+typedef struct AstBuilder {
+  Arena arena;
+  Node **slots;
+  int nslots; /* a power of two */
+  int count;
+  InternTable vars;
+  int optimize;
+  Node **operands;
+  char *ops;
+  int stackCapacity;
+  struct Frame *frames;
+  int nframes;
+  int frameCapacity;
+} AstBuilder;
+
+void initAstBuilder(AstBuilder *b);
+void clearAstBuilder(AstBuilder *b);
+void freeAstBuilder(AstBuilder *b);
+Node *buildExpression(List *lp, AstBuilder *b);
+void compileAst(Node *root, AstBuilder *b, Program *p);
+
+#endif
@@ -0,0 +1,157 @@
+/* benchBatch.c
+ *
+ * Benchmark for the compiled expressions of bytecode.h: a few expressions are compiled with
+ * compileExpression and evaluated at NPOINTS random points, one point at a time with runProgram
+ * and all at once with runProgramBatch. The batch must give the same values as runProgram, and
+ * runProgram the same as the expression written in C, with the arguments placed by
+ * variableSlot; the speedup of the batch is reported per expression:
+ *   benchBatch
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* malloc, free, rand */
+#include <string.h> /* strlen, strcpy */
+#include <math.h>   /* fabs */
+#include <time.h>   /* clock_gettime */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "bytecode.h"
+
+#define NPOINTS 10000000
+#define ROUNDS 3
+#define NVARS 3
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double *makeArray(size_t n) {
+  double *a = malloc(n * sizeof(double));
+  assert(a != NULL);
+  return a;
+}
+
+/* The expressions of the benchmark, with the same expressions in C, as functions of the
+ * values of x, y and z.
+ */
+
+static double f0(const double *v) {
+  return v[0] * (v[1] + 1) - v[2] / 2;
+}
+
+static double f1(const double *v) {
+  return (v[0] + v[1]) * (v[0] - v[1]) / (1 + v[2] * v[2]);
+}
+
+static double f2(const double *v) {
+  return 3 * v[0] + 2 * v[1] - v[0] * v[1] * v[2];
+}
+
+static double f3(const double *v) {
+  return v[1];
+}
+
+static const char *expressions[] = {
+  "x * (y + 1) - z / 2",
+  "(x + y) * (x - y) / (1 + z * z)",
+  "3 * x + 2 * y - x * y * z",
+  "y"
+};
+
+static double (*functions[])(const double *) = {f0, f1, f2, f3};
+
+static const char *names[NVARS] = {"x", "y", "z"};
+
+/* The function benchExpression compiles expression e, checks and times it on the columns of
+ * the values of x, y and z, and yields the number of wrong values.
+ */
+
+static int benchExpression(int e, const double *const *xyz, double *out) {
+  char *ar = malloc(strlen(expressions[e]) + 1);
+  const double *columns[NVARS];
+  double args[NVARS], v[NVARS];
+  int slot[NVARS];
+  double t0, t, scalar = -1, batch = -1, w;
+  List tl, tl1;
+  Program p;
+  size_t i;
+  int r, k, ok, bad = 0;
+  assert(ar != NULL);
+  strcpy(ar, expressions[e]);
+  tl = tokenList(ar);
+  tl1 = tl;
+  initProgram(&p);
+  ok = compileExpression(&tl1, &p);
+  assert(ok && tl1 == NULL);
+  for (k = 0; k < NVARS; k++) {
+    slot[k] = variableSlot(&p, names[k]);
+    assert(slot[k] < p.vars.count);
+    if (slot[k] >= 0) {
+      columns[slot[k]] = xyz[k];
+    }
+  }
+  assert(variableSlot(&p, "w") == -1);
+  for (r = 0; r < ROUNDS; r++) {
+    t0 = seconds();
+    for (i = 0; i < NPOINTS; i++) {
+      for (k = 0; k < p.vars.count; k++) {
+        args[k] = columns[k][i];
+      }
+      out[i] = runProgram(&p, args);
+    }
+    t = seconds() - t0;
+    scalar = (scalar < 0 || t < scalar ? t : scalar);
+  }
+  for (i = 0; i < NPOINTS; i++) {
+    for (k = 0; k < NVARS; k++) {
+      v[k] = xyz[k][i];
+    }
+    w = functions[e](v);
+    bad += (fabs(out[i] - w) > 1e-12 * (1 + fabs(w)));
+  }
+  for (r = 0; r < ROUNDS; r++) {
+    t0 = seconds();
+    runProgramBatch(&p, columns, out, NPOINTS);
+    t = seconds() - t0;
+    batch = (batch < 0 || t < batch ? t : batch);
+  }
+  /* the batch must agree exactly with runProgram */
+  for (i = 0; i < NPOINTS; i++) {
+    for (k = 0; k < p.vars.count; k++) {
+      args[k] = columns[k][i];
+    }
+    bad += (out[i] != runProgram(&p, args));
+  }
+  printf("%-32s %6.2f ns/point scalar %6.2f ns/point batch %5.1fx\n", expressions[e],
+         scalar / NPOINTS * 1e9, batch / NPOINTS * 1e9, scalar / batch);
+  freeProgram(&p);
+  freeTokenList(tl);
+  free(ar);
+  return bad;
+}
+
+int main(int argc, char *argv[]) {
+  double *xyz[NVARS];
+  double *out = makeArray(NPOINTS);
+  size_t i;
+  int e, k, bad = 0;
+  for (k = 0; k < NVARS; k++) {
+    xyz[k] = makeArray(NPOINTS);
+    for (i = 0; i < NPOINTS; i++) {
+      xyz[k][i] = (rand() % 2001 - 1000) / 10.0;
+    }
+  }
+  for (e = 0; e < (int)(sizeof(expressions) / sizeof(expressions[0])); e++) {
+    bad += benchExpression(e, (const double *const *)xyz, out);
+  }
+  assert(bad == 0);
+  for (k = 0; k < NVARS; k++) {
+    free(xyz[k]);
+  }
+  free(out);
+  return 0;
+}
@@ -0,0 +1,129 @@
+/* benchLinsys.c
+ *
+ * Benchmark for the blocked LU factorization of linsys.h: random systems of n equations in n
+ * variables are solved with luFactor and luSolve, and with plain Gaussian elimination with
+ * partial pivoting, which updates the whole trailing matrix once per column. Both are given
+ * as GFLOP/s, with 2n^3/3 operations for the elimination, and the largest residual of the
+ * solutions is printed to check them:
+ *   benchLinsys [n ...]
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* malloc, free, rand, atoi */
+#include <string.h> /* memcpy */
+#include <math.h>   /* fabs */
+#include <time.h>   /* clock_gettime */
+#include <assert.h> /* assert */
+#include "linsys.h"
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The function eliminate is plain Gaussian elimination on the matrix a of n rows and the right
+ * hand side b, with the solution left in b.
+ */
+
+static void eliminate(double *a, double *b, int n) {
+  double l, t;
+  int i, j, k, p;
+  for (k = 0; k < n; k++) {
+    p = k;
+    for (i = k + 1; i < n; i++) {
+      if (fabs(a[(size_t)i * n + k]) > fabs(a[(size_t)p * n + k])) {
+        p = i;
+      }
+    }
+    for (j = 0; j < n; j++) {
+      t = a[(size_t)k * n + j];
+      a[(size_t)k * n + j] = a[(size_t)p * n + j];
+      a[(size_t)p * n + j] = t;
+    }
+    t = b[k];
+    b[k] = b[p];
+    b[p] = t;
+    for (i = k + 1; i < n; i++) {
+      l = a[(size_t)i * n + k] / a[(size_t)k * n + k];
+      for (j = k; j < n; j++) {
+        a[(size_t)i * n + j] -= l * a[(size_t)k * n + j];
+      }
+      b[i] -= l * b[k];
+    }
+  }
+  for (i = n - 1; i >= 0; i--) {
+    for (j = i + 1; j < n; j++) {
+      b[i] -= a[(size_t)i * n + j] * b[j];
+    }
+    b[i] = b[i] / a[(size_t)i * n + i];
+  }
+}
+
+/* The function residual yields the largest |Ax - b| of the solution x. */
+
+static double residual(const double *a, const double *b, const double *x, int n) {
+  double r, worst = 0;
+  int i, j;
+  for (i = 0; i < n; i++) {
+    r = -b[i];
+    for (j = 0; j < n; j++) {
+      r += a[(size_t)i * n + j] * x[j];
+    }
+    worst = (fabs(r) > worst ? fabs(r) : worst);
+  }
+  return worst;
+}
+
+static void benchSize(int n) {
+  size_t size = (size_t)n * n;
+  double *a = malloc(size * sizeof(double)), *lu = malloc(size * sizeof(double));
+  double *b = malloc(n * sizeof(double)), *x = malloc(n * sizeof(double));
+  int *piv = malloc(n * sizeof(int));
+  double flops = 2.0 * n * n * n / 3, t0, tBlocked, tPlain, rBlocked, rPlain;
+  size_t i;
+  assert(a != NULL && lu != NULL && b != NULL && x != NULL && piv != NULL);
+  for (i = 0; i < size; i++) {
+    a[i] = (rand() % 2001 - 1000) / 100.0;
+  }
+  for (i = 0; i < (size_t)n; i++) {
+    b[i] = (rand() % 2001 - 1000) / 100.0;
+  }
+  memcpy(lu, a, size * sizeof(double));
+  memcpy(x, b, n * sizeof(double));
+  t0 = seconds();
+  assert(luFactor(lu, n, n, piv, 0));
+  luSolve(lu, n, n, piv, x);
+  tBlocked = seconds() - t0;
+  rBlocked = residual(a, b, x, n);
+  memcpy(lu, a, size * sizeof(double));
+  memcpy(x, b, n * sizeof(double));
+  t0 = seconds();
+  eliminate(lu, x, n);
+  tPlain = seconds() - t0;
+  rPlain = residual(a, b, x, n);
+  printf("n = %5d  luFactor %6.2f GFLOP/s  elimination %6.2f GFLOP/s  residuals %.1e %.1e\n",
+         n, flops / tBlocked * 1e-9, flops / tPlain * 1e-9, rBlocked, rPlain);
+  free(a);
+  free(lu);
+  free(b);
+  free(x);
+  free(piv);
+}
+
+int main(int argc, char *argv[]) {
+  static const int sizes[] = {100, 300, 1000, 2000};
+  int i;
+  if (argc > 1) {
+    for (i = 1; i < argc; i++) {
+      benchSize(atoi(argv[i]));
+    }
+  } else {
+    for (i = 0; i < 4; i++) {
+      benchSize(sizes[i]);
+    }
+  }
+  return 0;
+}
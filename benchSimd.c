@@ -0,0 +1,113 @@
+/* benchSimd.c
+ *
+ * Microbenchmark for simd.h: a buffer of SIZE bytes with numbers of up to 12 digits between
+ * runs of spaces, like the generated inputs, is scanned for numbers with the loop that
+ * scanLine and matchNumber used before, one byte at a time with ctype.h, and with
+ * skipSpaces, skipDigits and digitsValue. Both loops must find the same numbers.
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* malloc, free, rand */
+#include <ctype.h>  /* isspace, isdigit */
+#include <time.h>   /* clock_gettime */
+#include <assert.h> /* assert */
+#include "simd.h"
+
+#define SIZE (1 << 24)
+#define ROUNDS 10
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static char *makeBuffer(int maxSpaces) {
+  char *s = malloc(SIZE);
+  int i = 0, k;
+  assert(s != NULL);
+  while (i < SIZE) {
+    for (k = rand() % maxSpaces + 1; k > 0 && i < SIZE; k--) {
+      s[i++] = (rand() % 8 == 0 ? '\t' : ' ');
+    }
+    for (k = rand() % 12 + 1; k > 0 && i < SIZE; k--) {
+      s[i++] = '0' + rand() % 10;
+    }
+    if (rand() % 4 == 0 && i < SIZE) {
+      s[i++] = '+';
+    }
+  }
+  return s;
+}
+
+/* The function scanBytes is the loop of scanLine and matchNumber before simd.h. */
+
+static unsigned scanBytes(const char *ar, int length, int *count) {
+  unsigned sum = 0;
+  int i = 0, n;
+  while (i < length) {
+    if (isspace(ar[i])) {
+      i++;
+    } else if (isdigit(ar[i])) {
+      n = 0;
+      while (i < length && isdigit(ar[i])) {
+        n = 10 * n + (ar[i] - '0');
+        i++;
+      }
+      sum += (unsigned)n;
+      (*count)++;
+    } else {
+      i++;
+    }
+  }
+  return sum;
+}
+
+static unsigned scanBlocks(const char *ar, int length, int *count) {
+  unsigned sum = 0;
+  int i = 0, end;
+  while (i < length) {
+    if (isspace(ar[i])) {
+      i = skipSpaces(ar, i, length);
+    } else if (isdigit(ar[i])) {
+      end = skipDigits(ar, i, length);
+      sum += (unsigned)digitsValue(ar + i, end - i, length - i); /* mod 2^32, as n above */
+      i = end;
+      (*count)++;
+    } else {
+      i++;
+    }
+  }
+  return sum;
+}
+
+static void bench(const char *what, char *s) {
+  double t0, tBytes, tBlocks;
+  unsigned sumBytes = 0, sumBlocks = 0;
+  int countBytes = 0, countBlocks = 0, r;
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    sumBytes += scanBytes(s, SIZE, &countBytes);
+  }
+  tBytes = seconds() - t0;
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    sumBlocks += scanBlocks(s, SIZE, &countBlocks);
+  }
+  tBlocks = seconds() - t0;
+  printf("%-16s bytes %7.1f MB/s   blocks %7.1f MB/s   speedup %.2fx\n", what,
+         ROUNDS * (SIZE / 1e6) / tBytes, ROUNDS * (SIZE / 1e6) / tBlocks, tBytes / tBlocks);
+  assert(sumBytes == sumBlocks && countBytes == countBlocks);
+}
+
+int main(int argc, char *argv[]) {
+  char *s = makeBuffer(4);
+  bench("short spaces", s);
+  free(s);
+  s = makeBuffer(40);
+  bench("long spaces", s);
+  free(s);
+  return 0;
+}
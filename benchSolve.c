@@ -0,0 +1,101 @@
+/* benchSolve.c
+ *
+ * Benchmark for the quadratic solver (solve.h): NEQ equations a x^2 + b x + c = 0 with random
+ * coefficients, stored as three arrays, are solved one at a time with solveQuadratic and all
+ * at once with solveQuadraticBatch. The batch reads 24 and writes 16 bytes per equation, so
+ * its speed is compared with that of copying the same amount of memory.
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* malloc, free, rand */
+#include <string.h> /* memcpy */
+#include <time.h>   /* clock_gettime */
+#include <assert.h> /* assert */
+#include "solve.h"
+
+#define NEQ (1 << 22)
+#define ROUNDS 10
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double *makeArray(size_t n) {
+  double *a = malloc(n * sizeof(double));
+  assert(a != NULL);
+  return a;
+}
+
+static double randomCoefficient() {
+  return (rand() % 2001 - 1000) / 10.0;
+}
+
+static void report(const char *what, double t) {
+  double perEq = t / ROUNDS / NEQ * 1e9;
+  printf("%-10s %6.2f ns/equation %7.2f GB/s\n", what, perEq, 40.0 / perEq);
+}
+
+int main(int argc, char *argv[]) {
+  double *a = makeArray(NEQ), *b = makeArray(NEQ), *c = makeArray(NEQ);
+  double *x1 = makeArray(NEQ), *x2 = makeArray(NEQ);
+  double *copy = makeArray(5 * (size_t)NEQ);
+  double t0, r1, r2;
+  size_t i;
+  int r, k, bad = 0;
+
+  for (i = 0; i < NEQ; i++) {
+    a[i] = randomCoefficient();
+    if (a[i] == 0) {
+      a[i] = 1;
+    }
+    b[i] = randomCoefficient();
+    c[i] = randomCoefficient();
+  }
+
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    for (i = 0; i < NEQ; i++) {
+      k = solveQuadratic(a[i], b[i], c[i], &x1[i], &x2[i]);
+      if (k == 0) {
+        x1[i] = x2[i] = 0;
+      }
+    }
+  }
+  report("scalar", seconds() - t0);
+
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    solveQuadraticBatch(a, b, c, x1, x2, NEQ);
+  }
+  report("batch", seconds() - t0);
+
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    memcpy(copy, a, NEQ * sizeof(double));
+    memcpy(copy + NEQ, b, NEQ * sizeof(double));
+    memcpy(copy + 2 * (size_t)NEQ, c, NEQ * sizeof(double));
+    memcpy(copy + 3 * (size_t)NEQ, x1, NEQ * sizeof(double));
+    memcpy(copy + 4 * (size_t)NEQ, x2, NEQ * sizeof(double));
+  }
+  report("memcpy", (seconds() - t0) / 2); /* memcpy reads and writes 40 bytes */
+
+  /* the batch must agree with the scalar solver */
+  for (i = 0; i < NEQ; i++) {
+    k = solveQuadratic(a[i], b[i], c[i], &r1, &r2);
+    if (k == 0 ? x1[i] == x1[i] : (x1[i] != r1 || x2[i] != r2)) {
+      bad++;
+    }
+  }
+  assert(bad == 0);
+  free(a);
+  free(b);
+  free(c);
+  free(x1);
+  free(x2);
+  free(copy);
+  return 0;
+}
@@ -0,0 +1,148 @@
+/* benchStages.c
+ *
+ * Benchmark of the stages of the interactive programs on the corpora of genCorpus: for every
+ * file the lines are scanned with tokenList, i.e. with malloc, recognized with acceptEquation,
+ * evaluated with valueExpression, with valueExpressionStack and with valueExpressionExact, and
+ * freed with freeTokenList, each stage for all lines at once. The best of ROUNDS rounds is
+ * reported per stage as megabytes of input per second and lines per second. The files must be
+ * regular files, which are mapped in memory as a whole:
+ *   benchStages file ...
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>  /* printf, perror */
+#include <stdlib.h> /* malloc, realloc, free */
+#include <time.h>   /* clock_gettime */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "input.h"
+#include "recognizeEq.h"
+#include "evalExp.h"
+
+#define ROUNDS 5
+
+enum Stage {
+  StageScan, StageRecognize, StageEvaluate, StageEvaluateStack, StageEvaluateExact, StageFree,
+  NSTAGES
+};
+
+static const char *stageNames[NSTAGES] = {
+  "tokenList", "acceptEquation", "valueExpression", "valueExprStack", "valueExprExact",
+  "freeTokenList"
+};
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The function benchFile runs the stages on the lines of the input in and prints the result.
+ * The counts of accepted lines are printed too, so the stages cannot be optimized away and
+ * the corpus can be checked at a glance.
+ */
+
+static void benchFile(const char *path, Input *in) {
+  Line *lines = NULL;
+  List *lists;
+  List tl;
+  RecogContext ctx;
+  EvalStack st;
+  double best[NSTAGES];
+  double t0, t, w;
+  Rational q;
+  size_t bytes = 0;
+  int nlines = 0, capacity = 0;
+  int equations = 0, expressions = 0, stackExpressions = 0, exactExpressions = 0;
+  int r, s, i;
+  Line line;
+  while (nextLine(in, &line)) {
+    if (nlines == capacity) {
+      capacity = (capacity == 0 ? 1024 : 2 * capacity);
+      lines = realloc(lines, capacity * sizeof(Line));
+      assert(lines != NULL);
+    }
+    lines[nlines++] = line;
+    bytes = bytes + line.length + 1;
+  }
+  lists = malloc((nlines + 1) * sizeof(List));
+  assert(lists != NULL);
+  initRecogContext(&ctx);
+  initEvalStack(&st);
+  for (s = 0; s < NSTAGES; s++) {
+    best[s] = -1;
+  }
+  for (r = 0; r < ROUNDS; r++) {
+    equations = 0;
+    expressions = 0;
+    stackExpressions = 0;
+    exactExpressions = 0;
+    for (s = 0; s < NSTAGES; s++) {
+      t0 = seconds();
+      for (i = 0; i < nlines; i++) {
+        switch (s) {
+        case StageScan:
+          lists[i] = tokenListSlice(lines[i].start, lines[i].length, NULL);
+          break;
+        case StageRecognize:
+          tl = lists[i];
+          equations += acceptEquation(&tl, &ctx) && tl == NULL;
+          break;
+        case StageEvaluate:
+          tl = lists[i];
+          expressions += valueExpression(&tl, &w) && tl == NULL;
+          break;
+        case StageEvaluateStack:
+          tl = lists[i];
+          stackExpressions += valueExpressionStack(&tl, &w, &st) && tl == NULL;
+          break;
+        case StageEvaluateExact:
+          tl = lists[i];
+          exactExpressions += valueExpressionExact(&tl, &q, &st) && tl == NULL;
+          break;
+        case StageFree:
+          freeTokenList(lists[i]);
+          break;
+        }
+      }
+      t = seconds() - t0;
+      if (best[s] < 0 || t < best[s]) {
+        best[s] = t;
+      }
+    }
+  }
+  printf("%s: %.1f MB, %d lines, %d equations, %d numerical expressions\n",
+         path, bytes / 1e6, nlines, equations, expressions);
+  for (s = 0; s < NSTAGES; s++) {
+    printf("  %-16s %9.1f MB/s %12.0f lines/s\n", stageNames[s],
+           bytes / best[s] / 1e6, nlines / best[s]);
+  }
+  assert(stackExpressions == expressions && exactExpressions == expressions);
+  freeRecogContext(&ctx);
+  freeEvalStack(&st);
+  free(lists);
+  free(lines);
+}
+
+int main(int argc, char *argv[]) {
+  Input in;
+  int i;
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s file ...\n", argv[0]);
+    return 1;
+  }
+  for (i = 1; i < argc; i++) {
+    if (!openInput(&in, argv[i])) {
+      perror(argv[i]);
+      return 1;
+    }
+    if (in.capacity != 0) { /* the lines are only kept when the file is mapped */
+      fprintf(stderr, "%s: %s is not a regular file\n", argv[0], argv[i]);
+      return 1;
+    }
+    benchFile(argv[i], &in);
+    closeInput(&in);
+  }
+  return 0;
+}
@@ -0,0 +1,128 @@
+/* benchTokens.c
+ *
+ * Benchmark that compares the token list with the token array (tokenArray.h) on long
+ * lines of 10000 tokens: an equation for the recognizer and an arithmetical expression
+ * for the evaluator. Only the walk over the tokens is timed, not the scanning.
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h>  /* printf, sprintf */
+#include <stdlib.h> /* malloc, free */
+#include <time.h>   /* clock_gettime */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "tokenArray.h"
+#include "recognizeEq.h"
+#include "evalExp.h"
+
+#define NTOKENS 10000
+#define ROUNDS 2000
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The function makeLine writes terms produced by the function term, separated by
+ * alternating '+' and '-', until the line has about ntokens tokens.
+ */
+
+static char *makeLine(int ntokens, int (*term)(char *s, int i), const char *tail) {
+  char *s = malloc(16 * ntokens + 64);
+  int n = 0, i = 0, len = 0;
+  assert(s != NULL);
+  while (n < ntokens) {
+    if (i > 0) {
+      len += sprintf(s + len, " %c ", (i % 2 ? '+' : '-'));
+      n++;
+    }
+    n += term(s + len, i);
+    while (s[len] != '\0') {
+      len++;
+    }
+    i++;
+  }
+  sprintf(s + len, "%s", tail);
+  return s;
+}
+
+static int equationTerm(char *s, int i) { /* 3 x ^ 2 : 4 tokens */
+  sprintf(s, "%dx^%d", i % 97 + 1, i % 5);
+  return 4;
+}
+
+static int expressionTerm(char *s, int i) { /* ( 3 * 4 / 2 ) : 7 tokens */
+  sprintf(s, "(%d * %d / %d)", i % 89 + 1, i % 7 + 1, i % 3 + 1);
+  return 7;
+}
+
+static void report(const char *what, double tList, double tArray, int ntokens) {
+  double perList = tList / ROUNDS / ntokens * 1e9;
+  double perArray = tArray / ROUNDS / ntokens * 1e9;
+  printf("%-12s list %6.2f ns/token   array %6.2f ns/token   speedup %.2fx\n",
+         what, perList, perArray, perList / perArray);
+}
+
+int main(int argc, char *argv[]) {
+  char *eq = makeLine(NTOKENS, equationTerm, " = 0");
+  char *ex = makeLine(NTOKENS, expressionTerm, "");
+  List tl, tl1;
+  TokenArray ta;
+  Cursor c;
+  Arena arena;
+  RecogContext ctx;
+  double t0, tList, tArray, w = 0, wList = 0, wArray = 0;
+  int r, ok = 0;
+
+  initArena(&arena);
+  initTokenArray(&ta);
+  initRecogContext(&ctx);
+
+  /* recognizer */
+  tl = tokenListArena(eq, &arena);
+  scanTokenArray(&ta, eq);
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    tl1 = tl;
+    ok += acceptEquation(&tl1, &ctx) && tl1 == NULL;
+  }
+  tList = seconds() - t0;
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    initCursor(&c, &ta);
+    ok += acceptEquationC(&c, &ctx) && cursorAtEnd(&c);
+  }
+  tArray = seconds() - t0;
+  report("acceptEq", tList, tArray, ta.length);
+  resetArena(&arena);
+
+  /* evaluator */
+  tl = tokenListArena(ex, &arena);
+  scanTokenArray(&ta, ex);
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    tl1 = tl;
+    ok += valueExpression(&tl1, &w) && tl1 == NULL;
+    wList = w;
+  }
+  tList = seconds() - t0;
+  t0 = seconds();
+  for (r = 0; r < ROUNDS; r++) {
+    initCursor(&c, &ta);
+    ok += valueExpressionC(&c, &w) && cursorAtEnd(&c);
+    wArray = w;
+  }
+  tArray = seconds() - t0;
+  report("valueExp", tList, tArray, ta.length);
+
+  /* both representations must accept the lines and agree on the value */
+  assert(ok == 4 * ROUNDS && wList == wArray);
+  freeArena(&arena);
+  freeTokenArray(&ta);
+  freeRecogContext(&ctx);
+  free(eq);
+  free(ex);
+  return 0;
+}
@@ -0,0 +1,428 @@
+/* bytecode.c
+ *
+ * In this file a compiler is defined that turns the token list of an arithmetical expression
+ * into a program for a stack machine, together with the machine that runs it.
+ * The grammar is the one of evalExp.c, in which a factor may also be an identifier:
+ *
+ * <expression>  ::= <term> { '+'  <term> | '-' <term> }
+ *
+ * <term>       ::= <factor> { '*' <factor> | '/' <factor> }
+ *
+ * <factor>     ::= <number> | <identifier> | '(' <expression> ')'
+ *
+ * Compiling is done by recursive descent, like evaluating in evalExp.c, but the operators are
+ * emitted instead of applied. The result can be run any number of times, each time with other
+ * values for the identifiers, without parsing the tokens again.
+ */
+
+#include <stdlib.h> /* NULL, malloc, realloc, free */
+#include <string.h> /* strcmp, memcpy */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "recognizeEq.h"
+#include "bytecode.h"
+
+void initProgram(Program *p) {
+  p->code = NULL;
+  p->length = 0;
+  p->capacity = 0;
+  p->consts = NULL;
+  p->nconsts = 0;
+  p->constCapacity = 0;
+  initInternTable(&p->vars);
+  p->depth = 0;
+  p->maxStack = 0;
+  p->ntemps = 0;
+  p->stack = NULL;
+  p->stackCapacity = 0;
+  p->blocks = NULL;
+  p->blockCapacity = 0;
+  p->pointers = NULL;
+  p->pointerCapacity = 0;
+}
+
+/* The function resetProgram empties the program so that a new expression can be compiled into
+ * it; the memory of p is reused.
+ */
+
+void resetProgram(Program *p) {
+  p->length = 0;
+  p->nconsts = 0;
+  clearInternTable(&p->vars);
+  p->depth = 0;
+  p->maxStack = 0;
+  p->ntemps = 0;
+}
+
+/* The function emit appends an instruction to the program and keeps track of the depth of the
+ * stack: a push makes it one deeper, an operator one less deep, and OpStore leaves it alone.
+ * OpStore arg copies the top of the stack into temporary arg, which OpTemp arg pushes again;
+ * the number of temporaries grows as needed.
+ */
+
+void emit(Program *p, OpCode op, int arg) {
+  if (p->length == p->capacity) {
+    p->capacity = (p->capacity == 0 ? 16 : 2 * p->capacity);
+    p->code = realloc(p->code, p->capacity * sizeof(Instr));
+    assert(p->code != NULL);
+  }
+  p->code[p->length].op = op;
+  p->code[p->length].arg = arg;
+  p->length++;
+  if (op == OpConst || op == OpLoad || op == OpTemp) {
+    p->depth++;
+    if (p->depth > p->maxStack) {
+      p->maxStack = p->depth;
+    }
+  } else if (op == OpStore) {
+    if (arg >= p->ntemps) {
+      p->ntemps = arg + 1;
+    }
+  } else {
+    p->depth--;
+  }
+}
+
+void emitConst(Program *p, double w) {
+  if (p->nconsts == p->constCapacity) {
+    p->constCapacity = (p->constCapacity == 0 ? 16 : 2 * p->constCapacity);
+    p->consts = realloc(p->consts, p->constCapacity * sizeof(double));
+    assert(p->consts != NULL);
+  }
+  p->consts[p->nconsts] = w;
+  emit(p, OpConst, p->nconsts);
+  p->nconsts++;
+}
+
+/* The functions compileFactor, compileTerm and compileExpression correspond with valueFactor,
+ * valueTerm and valueExpression in evalExp.c: they yield 1 when an initial segment of the token
+ * list is a factor, term or expression, and then the pointer points to the rest of the list.
+ */
+
+static int compileSum(List *lp, Program *p);
+
+static int compileFactor(List *lp, Program *p) {
+  List l = *lp;
+  if (l != NULL && l->tt == Number) {
+    emitConst(p, numberValue(l));
+    *lp = l->next;
+    return 1;
+  }
+  if (l != NULL && l->tt == Identifier) {
+    emit(p, OpLoad, internIdentifier(&p->vars, (l->t).identifier, l->length));
+    *lp = l->next;
+    return 1;
+  }
+  return acceptCharacter(lp, '(') && compileSum(lp, p) && acceptCharacter(lp, ')');
+}
+
+static int compileTerm(List *lp, Program *p) {
+  if (!compileFactor(lp, p)) {
+    return 0;
+  }
+  while (*lp != NULL) {
+    if (acceptCharacter(lp, '*')) {
+      if (!compileFactor(lp, p)) {
+        return 0;
+      }
+      emit(p, OpMul, 0);
+    } else if (acceptCharacter(lp, '/')) {
+      if (!compileFactor(lp, p)) {
+        return 0;
+      }
+      emit(p, OpDiv, 0);
+    } else {
+      return 1;
+    }
+  }
+  return 1;
+}
+
+static int compileSum(List *lp, Program *p) {
+  if (!compileTerm(lp, p)) {
+    return 0;
+  }
+  while (*lp != NULL) {
+    if (acceptCharacter(lp, '+')) {
+      if (!compileTerm(lp, p)) {
+        return 0;
+      }
+      emit(p, OpAdd, 0);
+    } else if (acceptCharacter(lp, '-')) {
+      if (!compileTerm(lp, p)) {
+        return 0;
+      }
+      emit(p, OpSub, 0);
+    } else {
+      return 1;
+    }
+  }
+  return 1;
+}
+
+/* The function finishProgram allocates the stack and the temporaries that runProgram needs,
+ * after all code has been emitted, unless there is room for them already.
+ */
+
+void finishProgram(Program *p) {
+  if (p->maxStack + p->ntemps > p->stackCapacity) {
+    p->stackCapacity = p->maxStack + p->ntemps;
+    free(p->stack);
+    p->stack = malloc(p->stackCapacity * sizeof(double));
+    assert(p->stack != NULL);
+  }
+}
+
+/* The function compileExpression compiles an expression into the program p, replacing what
+ * p contained before.
+ */
+
+int compileExpression(List *lp, Program *p) {
+  resetProgram(p);
+  if (!compileSum(lp, p)) {
+    return 0;
+  }
+  finishProgram(p);
+  return 1;
+}
+
+/* The function variableSlot yields the number of the variable with the given name, which is
+ * the index of its value in the array that is passed to runProgram, or -1 when the expression
+ * does not contain the name.
+ */
+
+int variableSlot(Program *p, const char *name) {
+  int i;
+  for (i = 0; i < p->vars.count; i++) {
+    if (strcmp(identifierName(&p->vars, i), name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* The function runProgram runs the program with vars[k] as the value of variable k, and yields
+ * the value of the expression. It uses the stack of the program, so a program must not be run
+ * by two threads at the same time.
+ */
+
+double runProgram(Program *p, const double *vars) {
+  const Instr *ip = p->code;
+  const Instr *end = p->code + p->length;
+  double *temps = p->stack + p->maxStack;
+  double *sp = p->stack; /* points just above the top of the stack */
+  for (; ip < end; ip++) {
+    switch (ip->op) {
+    case OpConst:
+      *sp++ = p->consts[ip->arg];
+      break;
+    case OpLoad:
+      *sp++ = vars[ip->arg];
+      break;
+    case OpTemp:
+      *sp++ = temps[ip->arg];
+      break;
+    case OpStore:
+      temps[ip->arg] = sp[-1];
+      break;
+    case OpAdd:
+      sp--;
+      sp[-1] = sp[-1] + sp[0];
+      break;
+    case OpSub:
+      sp--;
+      sp[-1] = sp[-1] - sp[0];
+      break;
+    case OpMul:
+      sp--;
+      sp[-1] = sp[-1] * sp[0];
+      break;
+    case OpDiv:
+      sp--;
+      sp[-1] = sp[-1] / sp[0];
+      break;
+    }
+  }
+  return sp[-1];
+}
+
+/* The functions below are the operations of runProgramBatch on blocks of m values.
+ * They are simple loops over arrays, which the compiler turns into SIMD code.
+ */
+
+static void fillBlock(double *d, double w, int m) {
+  int j;
+  for (j = 0; j < m; j++) {
+    d[j] = w;
+  }
+}
+
+static void addBlock(double *d, const double *a, const double *b, int m) {
+  int j;
+  for (j = 0; j < m; j++) {
+    d[j] = a[j] + b[j];
+  }
+}
+
+static void subBlock(double *d, const double *a, const double *b, int m) {
+  int j;
+  for (j = 0; j < m; j++) {
+    d[j] = a[j] - b[j];
+  }
+}
+
+static void mulBlock(double *d, const double *a, const double *b, int m) {
+  int j;
+  for (j = 0; j < m; j++) {
+    d[j] = a[j] * b[j];
+  }
+}
+
+static void divBlock(double *d, const double *a, const double *b, int m) {
+  int j;
+  for (j = 0; j < m; j++) {
+    d[j] = a[j] / b[j];
+  }
+}
+
+/* The function runProgramBatch evaluates the expression at n points: out[i] becomes its value
+ * when variable k has the value columns[k][i]. The points are handled in blocks of BATCHBLOCK:
+ * every instruction is executed for a whole block at once, so the interpretation overhead is
+ * paid once per block instead of once per point, and the arithmetic runs column by column
+ * over consecutive memory. The stack holds pointers to blocks: a load points into the column
+ * itself, so variables are not copied. The last result is written into out directly.
+ * Temporaries are blocks behind the stack blocks.
+ * Like runProgram it uses memory of the program, so it must not run on two threads at once.
+ */
+
+void runProgramBatch(Program *p, const double *const *columns, double *out, size_t n) {
+  const double **top;
+  const double **stack;
+  double *temps;
+  double *d;
+  size_t base;
+  int i, m, k;
+  if (p->maxStack > p->pointerCapacity) {
+    p->pointerCapacity = p->maxStack;
+    free(p->pointers);
+    p->pointers = malloc(p->pointerCapacity * sizeof(double *));
+    assert(p->pointers != NULL);
+  }
+  stack = p->pointers;
+  if (p->maxStack + p->ntemps > p->blockCapacity) {
+    p->blockCapacity = p->maxStack + p->ntemps;
+    free(p->blocks);
+    p->blocks = malloc(p->blockCapacity * BATCHBLOCK * sizeof(double));
+    assert(p->blocks != NULL);
+  }
+  temps = p->blocks + p->maxStack * BATCHBLOCK;
+  for (base = 0; base < n; base += m) {
+    m = (n - base < BATCHBLOCK ? n - base : BATCHBLOCK);
+    top = stack; /* points just above the top of the stack */
+    for (i = 0; i < p->length; i++) {
+      k = top - stack; /* the block of the stack entry that is pushed or overwritten */
+      switch (p->code[i].op) {
+      case OpConst:
+        fillBlock(p->blocks + k * BATCHBLOCK, p->consts[p->code[i].arg], m);
+        *top++ = p->blocks + k * BATCHBLOCK;
+        break;
+      case OpLoad:
+        *top++ = columns[p->code[i].arg] + base;
+        break;
+      case OpTemp:
+        *top++ = temps + p->code[i].arg * BATCHBLOCK;
+        break;
+      case OpStore:
+        memcpy(temps + p->code[i].arg * BATCHBLOCK, top[-1], m * sizeof(double));
+        break;
+      default:
+        top--;
+        k--;
+        /* the final operation writes the result straight into out */
+        d = (i == p->length - 1 ? out + base : p->blocks + (k - 1) * BATCHBLOCK);
+        switch (p->code[i].op) {
+        case OpAdd:
+          addBlock(d, top[-1], top[0], m);
+          break;
+        case OpSub:
+          subBlock(d, top[-1], top[0], m);
+          break;
+        case OpMul:
+          mulBlock(d, top[-1], top[0], m);
+          break;
+        default:
+          divBlock(d, top[-1], top[0], m);
+          break;
+        }
+        top[-1] = d;
+        break;
+      }
+    }
+    if (top[-1] != out + base) { /* a program without operators: a single number or variable */
+      memcpy(out + base, top[-1], m * sizeof(double));
+    }
+  }
+}
+
+void freeProgram(Program *p) {
+  free(p->code);
+  free(p->blocks);
+  free(p->pointers);
+  free(p->consts);
+  freeInternTable(&p->vars);
+  free(p->stack);
+  initProgram(p);
+}
+
+void initBindings(Bindings *b) {
+  initInternTable(&b->names);
+  b->values = NULL;
+  b->capacity = 0;
+  b->args = NULL;
+  b->argsCapacity = 0;
+}
+
+/* The function bindVariable gives the identifier of the given length at name the value value;
+ * a name that was bound before gets the new value.
+ */
+
+void bindVariable(Bindings *b, const char *name, int length, double value) {
+  int id = internIdentifier(&b->names, name, length);
+  if (id >= b->capacity) {
+    b->capacity = 2 * id + 8;
+    b->values = realloc(b->values, b->capacity * sizeof(double));
+    assert(b->values != NULL);
+  }
+  b->values[id] = value;
+}
+
+/* The function bindProgram yields the array of arguments for runProgram, in the order of the
+ * variables of p, or NULL when a variable of p has no value. The array belongs to b and is
+ * overwritten by the next call.
+ */
+
+const double *bindProgram(Bindings *b, Program *p) {
+  int i, id;
+  const char *name;
+  if (p->vars.count > b->argsCapacity) {
+    b->argsCapacity = p->vars.count;
+    b->args = realloc(b->args, b->argsCapacity * sizeof(double));
+    assert(b->args != NULL);
+  }
+  for (i = 0; i < p->vars.count; i++) {
+    name = identifierName(&p->vars, i);
+    id = findIdentifier(&b->names, name, p->vars.length[i]);
+    if (id < 0) { /* the name has not been bound */
+      return NULL;
+    }
+    b->args[i] = b->values[id];
+  }
+  return b->args;
+}
+
+void freeBindings(Bindings *b) {
+  freeInternTable(&b->names);
+  free(b->values);
+  free(b->args);
+  initBindings(b);
+}
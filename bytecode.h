@@ -0,0 +1,88 @@
+/* bytecode.h, compiled expressions for repeated evaluation */
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stddef.h> /* size_t */
+#include "scanner.h"
+
+/* A program is an expression compiled to postfix code for a stack machine:
+ * OpConst pushes consts[arg], OpLoad pushes the value of variable arg, and OpAdd, OpSub,
+ * OpMul and OpDiv replace the two topmost values by their sum, difference, product or quotient;
+ * OpStore arg keeps a copy of the topmost value in temporary arg and OpTemp arg pushes it.
+ * The variables are the identifiers of the expression, numbered in order of appearance;
+ * vars gives their names. maxStack is the deepest the stack gets when the program runs, and
+ * ntemps is the number of temporaries.
+ * stack and blocks are the stacks of runProgram and runProgramBatch, with room for
+ * stackCapacity values and blockCapacity blocks of BATCHBLOCK values, and pointers is the
+ * stack of pointers to blocks of runProgramBatch, with room for pointerCapacity of them; they
+ * only grow, so a program that is compiled again and again needs no new memory once they are
+ * large enough.
+ */
+
+#define BATCHBLOCK 256 /* number of points that runProgramBatch handles per instruction */
+
+typedef enum OpCode {
+  OpConst,
+  OpLoad,
+  OpAdd,
+  OpSub,
+  OpMul,
+  OpDiv,
+  OpStore,
+  OpTemp
+} OpCode;
+
+typedef struct Instr {
+  OpCode op;
+  int arg;
+} Instr;
+
+typedef struct Program {
+  Instr *code;
+  int length;
+  int capacity;
+  double *consts;
+  int nconsts;
+  int constCapacity;
+  InternTable vars;
+  int depth;
+  int maxStack;
+  int ntemps;
+  double *stack;
+  int stackCapacity;
+  double *blocks;
+  int blockCapacity;
+  const double **pointers;
+  int pointerCapacity;
+} Program;
+
+void initProgram(Program *p);
+void resetProgram(Program *p);
+void emit(Program *p, OpCode op, int arg);
+void emitConst(Program *p, double w);
+void finishProgram(Program *p);
+int compileExpression(List *lp, Program *p);
+int variableSlot(Program *p, const char *name);
+double runProgram(Program *p, const double *vars);
+void runProgramBatch(Program *p, const double *const *columns, double *out, size_t n);
+void freeProgram(Program *p);
+
+/* Bindings give values to identifiers by name: names holds the bound names, and values[id]
+ * is the value of the name with that id. args is room for the arguments of a program.
+ */
+
+typedef struct Bindings {
+  InternTable names;
+  double *values;
+  int capacity;
+  double *args;
+  int argsCapacity;
+} Bindings;
+
+void initBindings(Bindings *b);
+void bindVariable(Bindings *b, const char *name, int length, double value);
+const double *bindProgram(Bindings *b, Program *p);
+void freeBindings(Bindings *b);
+
+#endif
@@ -0,0 +1,283 @@
+/* cache.c
+ *
+ * In this file the answer cache of cache.h is defined. Input streams repeat the same lines
+ * often, so recog and eval can look up the answer to a line instead of recognizing or
+ * evaluating it again. The lookup needs only the token list, which has been made anyway to
+ * print it, so the key is built from the tokens and not from the characters of the line.
+ */
+
+#define _POSIX_C_SOURCE 200809L /* open_memstream */
+
+#include <stdio.h>  /* open_memstream, fwrite, fflush, ftell, fprintf */
+#include <stdlib.h> /* NULL, malloc, realloc, free */
+#include <string.h> /* memcmp, memcpy */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "cache.h"
+
+#define INITSLOTS 1024 /* initial number of slots in the hash table */
+
+void initCache(Cache *c, size_t capacity) {
+  int i;
+  c->nslots = INITSLOTS;
+  c->slots = malloc(c->nslots * sizeof(CacheEntry *));
+  assert(c->slots != NULL);
+  for (i = 0; i < c->nslots; i++) {
+    c->slots[i] = NULL;
+  }
+  c->count = 0;
+  c->newest = NULL;
+  c->oldest = NULL;
+  c->bytes = 0;
+  c->capacity = capacity;
+  c->hits = 0;
+  c->misses = 0;
+  c->evictions = 0;
+  c->key = NULL;
+  c->keyLength = 0;
+  c->keyCapacity = 0;
+  c->keyHash = 0;
+  c->captured = NULL;
+  c->capturedLength = 0;
+  c->capture = open_memstream(&c->captured, &c->capturedLength);
+  assert(c->capture != NULL);
+}
+
+void freeCache(Cache *c) {
+  CacheEntry *e = c->newest;
+  CacheEntry *older;
+  while (e != NULL) {
+    older = e->older;
+    free(e);
+    e = older;
+  }
+  free(c->slots);
+  free(c->key);
+  fclose(c->capture);
+  free(c->captured);
+}
+
+/* The function appendKey appends the n bytes at p to the key; its size is doubled when
+ * necessary.
+ */
+
+static void appendKey(Cache *c, const void *p, int n) {
+  if (c->keyLength + n > c->keyCapacity) {
+    c->keyCapacity = (c->keyCapacity == 0 ? 256 : c->keyCapacity);
+    while (c->keyLength + n > c->keyCapacity) {
+      c->keyCapacity = 2 * c->keyCapacity;
+    }
+    c->key = realloc(c->key, c->keyCapacity);
+    assert(c->key != NULL);
+  }
+  memcpy(c->key + c->keyLength, p, n);
+  c->keyLength = c->keyLength + n;
+}
+
+/* The function makeKey builds the key of the token list tl, see cache.h, and its FNV-1a hash,
+ * as in intern.c. Every token starts with a byte for its type, and an identifier has its
+ * length before its name, so different token lists have different keys. An integer is keyed
+ * by its exact value, since NumLong integers above 2^53, like 9007199254740992 and
+ * 9007199254740993, are the same double. A NumDecimal number has its double and also the
+ * characters with which it was written, after their number, since in exact mode the answer
+ * depends on them and not only on the double: 0.3333333333333333 and 0.33333333333333331 are
+ * the same double.
+ */
+
+static void makeKey(Cache *c, List tl) {
+  unsigned char tag[2];
+  unsigned h = 2166136261u;
+  double w;
+  int i;
+  c->keyLength = 0;
+  while (tl != NULL) {
+    tag[0] = (unsigned char)tl->tt;
+    switch (tl->tt) {
+    case Number:
+      tag[1] = (unsigned char)tl->kind;
+      appendKey(c, tag, 2);
+      if (tl->kind == NumInt) {
+        appendKey(c, &(tl->t).number, sizeof(int));
+      } else if (tl->kind == NumLong) {
+        appendKey(c, &(tl->t).wide, sizeof(long long));
+      } else {
+        w = numberValue(tl);
+        appendKey(c, &w, sizeof(double));
+      }
+      if (numberLiteral(tl) != NULL) {
+        appendKey(c, &tl->length, sizeof(int));
+        appendKey(c, numberLiteral(tl), tl->length);
+      }
+      break;
+    case Identifier:
+      appendKey(c, tag, 1);
+      appendKey(c, &tl->length, sizeof(int));
+      appendKey(c, (tl->t).identifier, tl->length);
+      break;
+    case Symbol:
+      tag[1] = (unsigned char)(tl->t).symbol;
+      appendKey(c, tag, 2);
+      break;
+    }
+    tl = tl->next;
+  }
+  for (i = 0; i < c->keyLength; i++) {
+    h = (h ^ (unsigned char)c->key[i]) * 16777619u;
+  }
+  c->keyHash = h;
+}
+
+/* The functions unlinkEntry and pushEntry take an entry out of the list of entries in the order
+ * of use, and put it in front of it as the newest one.
+ */
+
+static void unlinkEntry(Cache *c, CacheEntry *e) {
+  if (e->newer != NULL) {
+    e->newer->older = e->older;
+  } else {
+    c->newest = e->older;
+  }
+  if (e->older != NULL) {
+    e->older->newer = e->newer;
+  } else {
+    c->oldest = e->newer;
+  }
+}
+
+static void pushEntry(Cache *c, CacheEntry *e) {
+  e->newer = NULL;
+  e->older = c->newest;
+  if (c->newest != NULL) {
+    c->newest->newer = e;
+  } else {
+    c->oldest = e;
+  }
+  c->newest = e;
+}
+
+/* The function lookupCache yields the answer to the token list tl and stores its length in
+ * *lp, or yields NULL when tl is not in the cache. The key of tl is kept for insertCache.
+ * The answer is not terminated by '\0'.
+ */
+
+const char *lookupCache(Cache *c, List tl, int *lp) {
+  CacheEntry *e;
+  makeKey(c, tl);
+  e = c->slots[c->keyHash & (c->nslots - 1)];
+  while (e != NULL) {
+    if (e->hash == c->keyHash && e->keyLength == c->keyLength &&
+        memcmp(e->data, c->key, c->keyLength) == 0) {
+      c->hits++;
+      unlinkEntry(c, e);
+      pushEntry(c, e);
+      *lp = e->valueLength;
+      return e->data + e->keyLength;
+    }
+    e = e->chain;
+  }
+  c->misses++;
+  return NULL;
+}
+
+/* The function evictOldest removes the least recently used entry from the cache. */
+
+static void evictOldest(Cache *c) {
+  CacheEntry *e = c->oldest;
+  CacheEntry **ep = &c->slots[e->hash & (c->nslots - 1)];
+  while (*ep != e) {
+    ep = &(*ep)->chain;
+  }
+  *ep = e->chain;
+  unlinkEntry(c, e);
+  c->bytes = c->bytes - (sizeof(CacheEntry) + e->keyLength + e->valueLength);
+  c->count--;
+  c->evictions++;
+  free(e);
+}
+
+/* The function growSlots doubles the number of slots and moves the entries to their new
+ * slots, so that the chains stay short.
+ */
+
+static void growSlots(Cache *c) {
+  CacheEntry **old = c->slots;
+  int nold = c->nslots;
+  CacheEntry *e, *next;
+  int i, j;
+  c->nslots = 2 * nold;
+  c->slots = malloc(c->nslots * sizeof(CacheEntry *));
+  assert(c->slots != NULL);
+  for (i = 0; i < c->nslots; i++) {
+    c->slots[i] = NULL;
+  }
+  for (i = 0; i < nold; i++) {
+    for (e = old[i]; e != NULL; e = next) {
+      next = e->chain;
+      j = e->hash & (c->nslots - 1);
+      e->chain = c->slots[j];
+      c->slots[j] = e;
+    }
+  }
+  free(old);
+}
+
+/* The function insertCache stores value[0..length-1] as the answer for the key of the last
+ * lookup, which must have failed. Entries are evicted until the new one fits; an entry that
+ * is larger than the whole cache is not stored.
+ */
+
+void insertCache(Cache *c, const char *value, int length) {
+  size_t size = sizeof(CacheEntry) + c->keyLength + length;
+  CacheEntry *e;
+  int j;
+  if (size > c->capacity) {
+    return;
+  }
+  while (c->bytes + size > c->capacity) {
+    evictOldest(c);
+  }
+  e = malloc(size);
+  assert(e != NULL);
+  e->hash = c->keyHash;
+  e->keyLength = c->keyLength;
+  e->valueLength = length;
+  memcpy(e->data, c->key, c->keyLength);
+  memcpy(e->data + c->keyLength, value, length);
+  j = e->hash & (c->nslots - 1);
+  e->chain = c->slots[j];
+  c->slots[j] = e;
+  pushEntry(c, e);
+  c->bytes = c->bytes + size;
+  c->count++;
+  if (c->count > c->nslots) {
+    growSlots(c);
+  }
+}
+
+/* The function answerCached prints on out the answer to the token list tl: the one in the
+ * cache, or else the one that answer prints, which is written into the memory stream capture
+ * first, so that it can be stored in the cache.
+ */
+
+void answerCached(Cache *c, FILE *out, List tl, Answer *answer, void *state) {
+  const char *value;
+  int length;
+  value = lookupCache(c, tl, &length);
+  if (value == NULL) {
+    rewind(c->capture);
+    answer(c->capture, tl, state);
+    fflush(c->capture);
+    length = (int)ftell(c->capture);
+    insertCache(c, c->captured, length);
+    value = c->captured;
+  }
+  fwrite(value, 1, length, out);
+}
+
+void printCacheStats(FILE *out, Cache *c) {
+  long long lookups = c->hits + c->misses;
+  fprintf(out, "cache: %lld hits, %lld misses (%.1f%% hits), %lld evictions, "
+          "%d entries in %lu bytes\n", c->hits, c->misses,
+          (lookups > 0 ? 100.0 * c->hits / lookups : 0.0), c->evictions, c->count,
+          (unsigned long)c->bytes);
+}
@@ -0,0 +1,64 @@
+/* cache.h, LRU cache of the answers to lines that have been seen before */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>  /* FILE */
+#include <stddef.h> /* size_t */
+#include "scanner.h"
+
+/* A cache maps token lists to the answers that recog or eval print for them. The key of a list
+ * is its normalized token stream: the type of every token with its value, i.e. the kind and
+ * the exact integer or the double of a number, the name of an identifier and the character of
+ * a symbol, and for a NumDecimal number (see scanner.h) also the characters with which it is
+ * written, when they are known. So lines that differ only in spaces, or in leading zeros of an
+ * integer that fits in a long long, as in 007 and 7, share one entry, but 2.5 and 2.50 do not.
+ * An entry holds the key and the answer text; entries are found with a hash table of chains,
+ * and are kept in a list from the most to the least recently used one. When the entries take
+ * more than capacity bytes, the least recently used ones are evicted.
+ * key is the key of the last lookup, and capture the memory stream in which a new answer
+ * is written, see answerCached.
+ */
+
+typedef struct CacheEntry {
+  unsigned hash;
+  int keyLength;
+  int valueLength;
+  struct CacheEntry *chain; /* the next entry in the same slot */
+  struct CacheEntry *newer;
+  struct CacheEntry *older;
+  char data[];              /* the key, followed by the value */
+} CacheEntry;
+
+typedef struct Cache {
+  CacheEntry **slots;
+  int nslots; /* a power of two */
+  int count;
+  CacheEntry *newest;
+  CacheEntry *oldest;
+  size_t bytes;
+  size_t capacity;
+  long long hits;
+  long long misses;
+  long long evictions;
+  char *key;
+  int keyLength;
+  int keyCapacity;
+  unsigned keyHash;
+  FILE *capture;
+  char *captured;
+  size_t capturedLength;
+} Cache;
+
+/* An Answer prints on out the answer to the token list tl; state is what it needs for that. */
+
+typedef void Answer(FILE *out, List tl, void *state);
+
+void initCache(Cache *c, size_t capacity);
+void freeCache(Cache *c);
+const char *lookupCache(Cache *c, List tl, int *lp);
+void insertCache(Cache *c, const char *value, int length);
+void answerCached(Cache *c, FILE *out, List tl, Answer *answer, void *state);
+void printCacheStats(FILE *out, Cache *c);
+
+#endif
@@ -0,0 +1,344 @@
+/* checkEqn.c
+ *
+ * Checks of libeqn.a for make check, on lines whose answers are known. Every check that fails
+ * is printed with its line in this file, and the program then exits with status 1. It is
+ * linked with --wrap for malloc, calloc and realloc, so that the allocations of the library
+ * can be counted; with -DNO_WRAP, for a linker without --wrap, they are not counted and the
+ * checks of checkAllocations only check the results:
+ *   checkEqn
+ */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* NULL, size_t, malloc, free */
+#include <string.h> /* strlen, strcpy */
+#include <math.h>   /* fabs */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "bytecode.h"
+#include "recognizeEq.h"
+#include "cache.h"
+#include "eqn.h"
+
+#define NLINES 6
+#define ROUNDS 10
+#define DEPTH 200000 /* parentheses of the lines of checkDepth */
+#define DEEP 100      /* operands on the stack of the deep line of checkAllocations */
+
+static int failures = 0;
+static long allocations = 0;
+
+/* The functions __wrap_malloc, __wrap_calloc and __wrap_realloc replace malloc, calloc and
+ * realloc in the library and count their calls.
+ */
+
+#ifndef NO_WRAP
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+  allocations++;
+  return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size) {
+  allocations++;
+  return __real_realloc(p, size);
+}
+#endif
+
+static void check(int ok, const char *what, int line) {
+  if (!ok) {
+    printf("checkEqn.c:%d: check failed: %s\n", line, what);
+    failures++;
+  }
+}
+
+#define CHECK(ok) check((ok), #ok, __LINE__)
+
+/* The function checkExpressions checks what kind of expression eqn_evaluate_batch finds, with
+ * and without values for the identifiers: an expression with identifiers is arithmetical for
+ * the whole grammar of eval, with '*', '/' and parentheses.
+ */
+
+static void checkExpressions() {
+  static const char *lines[] = {
+    "x * (y + 1)", "2 * x", "x + 1", "x / (2 - y) * x", "3 * 4", "(x", "x * * 2", "x = 1"
+  };
+  eqn_context *ctx = eqn_create();
+  eqn_value v[8];
+  eqn_evaluate_batch(ctx, lines, 8, v);
+  CHECK(v[0].kind == EQN_ARITHMETICAL);
+  CHECK(v[1].kind == EQN_ARITHMETICAL);
+  CHECK(v[2].kind == EQN_ARITHMETICAL);
+  CHECK(v[3].kind == EQN_ARITHMETICAL);
+  CHECK(v[4].kind == EQN_NUMERICAL && v[4].value == 12);
+  CHECK(v[5].kind == EQN_NOT_EXPRESSION);
+  CHECK(v[6].kind == EQN_NOT_EXPRESSION);
+  CHECK(v[7].kind == EQN_NOT_EXPRESSION);
+  eqn_bind(ctx, "x", 2);
+  eqn_evaluate_batch(ctx, lines, 8, v);
+  CHECK(v[0].kind == EQN_ARITHMETICAL);
+  CHECK(v[1].kind == EQN_BOUND && v[1].value == 4);
+  CHECK(v[2].kind == EQN_BOUND && v[2].value == 3);
+  eqn_bind(ctx, "y", 3);
+  eqn_evaluate_batch(ctx, lines, 8, v);
+  CHECK(v[0].kind == EQN_BOUND && v[0].value == 8);
+  CHECK(v[3].kind == EQN_BOUND && v[3].value == -4);
+  CHECK(v[5].kind == EQN_NOT_EXPRESSION);
+  eqn_destroy(ctx);
+}
+
+/* The function checkEquations checks the kinds of equations that eqn_classify_batch finds and
+ * their numbers of variables, also when there are more than the recognizer keeps.
+ */
+
+static void checkEquations() {
+  static const char *lines[] = {
+    "x + y = 1", "a + b + c + d + e + f + g + h + i = 0", "2x^2 = 8", "x + = 1", "x ^ 2"
+  };
+  eqn_context *ctx = eqn_create();
+  eqn_result r[5];
+  eqn_classify_batch(ctx, lines, 5, r);
+  CHECK(r[0].cls == EQN_EQUATION && r[0].nvars == 2 && !r[0].overflow);
+  CHECK(r[1].cls == EQN_EQUATION && r[1].nvars == 8 && r[1].overflow);
+  CHECK(r[2].cls == EQN_EQUATION_1VAR && r[2].degree == 2 && r[2].nvars == 1 && !r[2].overflow);
+  CHECK(r[2].nsolutions == 2 && r[2].solutions[0] == -2 && r[2].solutions[1] == 2);
+  CHECK(r[3].cls == EQN_NOT_EQUATION && r[3].nvars == 0);
+  CHECK(r[4].cls == EQN_NOT_EQUATION);
+  eqn_destroy(ctx);
+}
+
+/* The function checkExact checks that in exact mode the fractions of the coefficients decide
+ * which terms cancel, and not the doubles, which leave a residue for 0.1 + 0.2 - 0.3.
+ */
+
+static void checkExact() {
+  char line0[] = "0.1x + 0.2x = 0.3x";
+  char line1[] = "0.1x^2 + 0.2x^2 - 0.3x^2 + 0.1x = 0.2";
+  RecogContext ctx;
+  List tl;
+  initRecogContext(&ctx);
+  ctx.exact = 1;
+  tl = scanLine(&ctx.scanner, line0, strlen(line0));
+  CHECK(classifyEquation(tl, &ctx) == EquationNVars && ctx.eq.vars.count == 0);
+  resetArena(&ctx.arena);
+  clearInternTable(&ctx.intern);
+  tl = scanLine(&ctx.scanner, line1, strlen(line1));
+  CHECK(classifyEquation(tl, &ctx) == Equation1Var && ctx.eq.degree == 1);
+  CHECK(ctx.eq.hasExactRoot && ctx.eq.exactRoot.num == 2 && ctx.eq.exactRoot.den == 1);
+  freeRecogContext(&ctx);
+}
+
+/* The function checkCache checks that integers above 2^53, which are the same double, do not
+ * share an entry of the answer cache.
+ */
+
+static void checkCache() {
+  char line0[] = "x = 9007199254740993";
+  char line1[] = "x = 9007199254740992";
+  Cache c;
+  Scanner sc;
+  List tl0, tl1;
+  int length;
+  initCache(&c, 1 << 20);
+  initScanner(&sc, NULL);
+  tl0 = scanLine(&sc, line0, strlen(line0));
+  tl1 = scanLine(&sc, line1, strlen(line1));
+  CHECK(lookupCache(&c, tl0, &length) == NULL);
+  insertCache(&c, "3", 1);
+  CHECK(lookupCache(&c, tl1, &length) == NULL);
+  CHECK(lookupCache(&c, tl0, &length) != NULL && length == 1);
+  freeTokenList(tl0);
+  freeTokenList(tl1);
+  freeCache(&c);
+}
+
+/* The function nested yields a line of depth open parentheses around x, with close of them
+ * closed again and then the given tail.
+ */
+
+static char *nested(int depth, const char *x, int close, const char *tail) {
+  char *line = malloc(depth + strlen(x) + close + strlen(tail) + 1);
+  char *p = line;
+  int i;
+  assert(line != NULL);
+  for (i = 0; i < depth; i++) {
+    *p++ = '(';
+  }
+  strcpy(p, x);
+  p += strlen(x);
+  for (i = 0; i < close; i++) {
+    *p++ = ')';
+  }
+  strcpy(p, tail);
+  return line;
+}
+
+/* The function checkDepth checks that eqn_evaluate_batch gets through lines that are nested
+ * far deeper than a stack of calls could be, with and without ')' for every '(', with numbers
+ * and with identifiers, whether or not they have a value.
+ */
+
+static void checkDepth() {
+  const char *lines[5];
+  eqn_context *ctx = eqn_create();
+  eqn_value v[5];
+  int i;
+  lines[0] = nested(DEPTH, "1", 0, "");
+  lines[1] = nested(DEPTH, "x", 0, "");
+  lines[2] = nested(DEPTH, "x", DEPTH - 1, "");
+  lines[3] = nested(DEPTH, "x", DEPTH, " + 1");
+  lines[4] = nested(DEPTH, "1", DEPTH, " * (x - 1)");
+  for (i = 0; i < 2; i++) {
+    eqn_evaluate_batch(ctx, lines, 5, v);
+    CHECK(v[0].kind == EQN_NOT_EXPRESSION);
+    CHECK(v[1].kind == EQN_NOT_EXPRESSION);
+    CHECK(v[2].kind == EQN_NOT_EXPRESSION);
+    CHECK(v[3].kind == (i == 0 ? EQN_ARITHMETICAL : EQN_BOUND));
+    CHECK(v[4].kind == (i == 0 ? EQN_ARITHMETICAL : EQN_BOUND));
+    eqn_bind(ctx, "x", 2);
+  }
+  CHECK(v[3].value == 3 && v[4].value == 1);
+  for (i = 0; i < 5; i++) {
+    free((char *)lines[i]);
+  }
+  eqn_destroy(ctx);
+}
+
+/* The function checkSolutions checks the solutions of equations with multiple roots: a root of
+ * multiplicity m is found by Newton's method only up to about the m-th root of the rounding
+ * errors, but it must be reported once and to full precision. Distinct roots that lie close
+ * together must not be merged, the roots of an even degree must be found also where Newton's
+ * method from 0 and the bound of the roots fails, and a degree above MAXDEGREE is too high.
+ */
+
+static void checkSolutions() {
+  static const char *lines[] = {
+    "x^3 - 3x^2 + 3x - 1 = 0", "x^4 - 4x^3 + 6x^2 - 4x + 1 = 0", "x^3 - 2x^2 + x = 0",
+    "x^3 - 3x - 2 = 0", "x^2 - 200000.05x + 10000005000 = 0", "x^2 - 0.000001x = 0",
+    "x^2 = 0.00000000000001", "x^6 - 6x^5 + x^4 + 8x^3 - 8x^2 + 8 = 0", "x^99999 = 1"
+  };
+  eqn_context *ctx = eqn_create();
+  eqn_result r[9];
+  eqn_classify_batch(ctx, lines, 9, r);
+  CHECK(r[0].cls == EQN_EQUATION_1VAR && r[0].nsolutions == 1);
+  CHECK(r[0].nsolutions == 1 && fabs(r[0].solutions[0] - 1) < 1e-12);
+  CHECK(r[1].nsolutions == 1 && fabs(r[1].solutions[0] - 1) < 1e-12);
+  CHECK(r[2].nsolutions == 2 && r[2].solutions[0] == 0 && fabs(r[2].solutions[1] - 1) < 1e-12);
+  CHECK(r[3].nsolutions == 2 && fabs(r[3].solutions[0] + 1) < 1e-12 &&
+        fabs(r[3].solutions[1] - 2) < 1e-12);
+  CHECK(r[4].nsolutions == 2 && fabs(r[4].solutions[0] - 100000) < 1e-4 &&
+        fabs(r[4].solutions[1] - 100000.05) < 1e-4);
+  CHECK(r[5].nsolutions == 2 && r[5].solutions[0] == 0 &&
+        fabs(r[5].solutions[1] - 1e-6) < 1e-18);
+  CHECK(r[6].nsolutions == 2 && fabs(r[6].solutions[0] + 1e-7) < 1e-19 &&
+        fabs(r[6].solutions[1] - 1e-7) < 1e-19);
+  CHECK(r[7].nsolutions == 3 && fabs(r[7].solutions[0] + 1) < 1e-12 &&
+        fabs(r[7].solutions[1] - 1.217) < 1e-3 && fabs(r[7].solutions[2] - 5.611) < 1e-3);
+  CHECK(!r[0].toohigh && r[8].degree == 99999 && r[8].toohigh && r[8].nsolutions == 0);
+  eqn_destroy(ctx);
+}
+
+/* The function deepLine yields the line x * (1 + x * (1 + ... x)) with n times x * (1 +, whose
+ * program needs a stack of 2n + 1 values.
+ */
+
+static char *deepLine(int n) {
+  char *line = malloc(10 * n + 2);
+  char *p = line;
+  int i;
+  assert(line != NULL);
+  for (i = 0; i < n; i++) {
+    strcpy(p, "x * (1 + ");
+    p += 9;
+  }
+  *p++ = 'x';
+  for (i = 0; i < n; i++) {
+    *p++ = ')';
+  }
+  *p = '\0';
+  return line;
+}
+
+/* The function checkAllocations checks that classifying and evaluating the same batch again
+ * and again allocates no memory once the buffers of the context have grown, as eqn.h promises,
+ * also for a line that is nested deeply; and so does runProgramBatch for its program.
+ */
+
+static void checkAllocations() {
+  const char *lines[NLINES] = {
+    "x^2 - 3x + 2 = 0", "x * (y + 1) - x * (y + 1)", "(x + y) / (x - y)", "2 * (3 + 4)",
+    "x + y = 1", NULL
+  };
+  eqn_context *ctx = eqn_create();
+  eqn_result results[NLINES];
+  eqn_value values[NLINES];
+  char *deep = deepLine(DEEP);
+  double ones[BATCHBLOCK + 1], out[BATCHBLOCK + 1];
+  const double *columns[1] = {ones};
+  List tl, tl1;
+  Program p;
+  long before;
+  int r, ok;
+  lines[NLINES - 1] = deep;
+  eqn_bind(ctx, "x", 2);
+  eqn_bind(ctx, "y", 3);
+  for (r = 0; r < ROUNDS; r++) { /* the arenas keep only their biggest block, which doubles */
+    eqn_classify_batch(ctx, lines, NLINES, results);
+    eqn_evaluate_batch(ctx, lines, NLINES, values);
+  }
+  before = allocations;
+  for (r = 0; r < ROUNDS; r++) {
+    eqn_classify_batch(ctx, lines, NLINES, results);
+  }
+  CHECK(allocations == before);
+  before = allocations;
+  for (r = 0; r < ROUNDS; r++) {
+    eqn_evaluate_batch(ctx, lines, NLINES, values);
+  }
+  CHECK(allocations == before);
+  CHECK(values[1].kind == EQN_BOUND && values[1].value == 0);
+  CHECK(values[2].kind == EQN_BOUND && values[2].value == -5);
+  CHECK(values[5].kind == EQN_BOUND);
+  eqn_destroy(ctx);
+  for (r = 0; r < BATCHBLOCK + 1; r++) {
+    ones[r] = 1;
+  }
+  tl = tokenList(deep);
+  tl1 = tl;
+  initProgram(&p);
+  ok = compileExpression(&tl1, &p);
+  CHECK(ok && tl1 == NULL && p.maxStack > 2 * DEEP);
+  runProgramBatch(&p, columns, out, BATCHBLOCK + 1);
+  before = allocations;
+  for (r = 0; r < ROUNDS; r++) {
+    runProgramBatch(&p, columns, out, BATCHBLOCK + 1);
+  }
+  CHECK(allocations == before);
+  CHECK(out[0] == DEEP + 1 && out[BATCHBLOCK] == DEEP + 1);
+  freeProgram(&p);
+  freeTokenList(tl);
+  free(deep);
+}
+
+int main(int argc, char *argv[]) {
+  checkEquations();
+  checkExact();
+  checkCache();
+  checkExpressions();
+  checkDepth();
+  checkSolutions();
+  checkAllocations();
+  if (failures > 0) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,146 @@
+/* eqn.c
+ *
+ * In this file the library interface of eqn.h is defined on top of the contexts of
+ * recognizeEq.h and evalExp.h. A line is scanned into the arena of the context, which is
+ * reset after every line, so a batch costs no allocations once the arenas, the equation and
+ * the pool of solutions are big enough for its lines.
+ */
+
+#include <stdlib.h> /* malloc, realloc, free */
+#include <string.h> /* strlen, memcpy */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "recognizeEq.h"
+#include "evalExp.h"
+#include "eqn.h"
+
+#define ROOTSIZE 256 /* initial size of the pool of solutions */
+
+/* An eqn_context holds a recognizer and an evaluator, the bindings of the evaluator, and the
+ * pool in which eqn_classify_batch keeps the solutions of a batch. The pool only grows.
+ */
+
+struct eqn_context {
+  RecogContext recog;
+  EvalContext eval;
+  Bindings bindings;
+  double *roots;
+  size_t nroots;
+  size_t capacity;
+};
+
+eqn_context *eqn_create(void) {
+  eqn_context *ctx = malloc(sizeof(eqn_context));
+  assert(ctx != NULL);
+  initRecogContext(&ctx->recog);
+  initBindings(&ctx->bindings);
+  initEvalContext(&ctx->eval, &ctx->bindings);
+  ctx->roots = NULL;
+  ctx->nroots = 0;
+  ctx->capacity = 0;
+  return ctx;
+}
+
+void eqn_destroy(eqn_context *ctx) {
+  if (ctx == NULL) {
+    return;
+  }
+  freeRecogContext(&ctx->recog);
+  freeEvalContext(&ctx->eval);
+  freeBindings(&ctx->bindings);
+  free(ctx->roots);
+  free(ctx);
+}
+
+void eqn_bind(eqn_context *ctx, const char *name, double value) {
+  bindVariable(&ctx->bindings, name, strlen(name), value);
+}
+
+/* The function keepRoots appends the n roots at xs to the pool and yields where they are
+ * kept. The size of the pool is doubled when necessary, as in readInput; when it moves, the
+ * solutions of out[0..done-1] are moved along. They lie in the pool one after the other.
+ */
+
+static const double *keepRoots(eqn_context *ctx, const double *xs, int n,
+                               eqn_result *out, size_t done) {
+  size_t i, pos = 0;
+  if (ctx->nroots + n > ctx->capacity) {
+    ctx->capacity = (ctx->capacity == 0 ? ROOTSIZE : ctx->capacity);
+    while (ctx->nroots + n > ctx->capacity) {
+      ctx->capacity = 2 * ctx->capacity;
+    }
+    ctx->roots = realloc(ctx->roots, ctx->capacity * sizeof(double));
+    assert(ctx->roots != NULL);
+    for (i = 0; i < done; i++) {
+      if (out[i].solutions != NULL) {
+        out[i].solutions = ctx->roots + pos;
+        pos = pos + out[i].nsolutions;
+      }
+    }
+  }
+  memcpy(ctx->roots + ctx->nroots, xs, n * sizeof(double));
+  ctx->nroots = ctx->nroots + n;
+  return ctx->roots + ctx->nroots - n;
+}
+
+/* The function eqn_classify_batch stores in out[i] what kind of equation lines[i] is, as
+ * recog prints it: the line is classified by classifyEquation, as in recognizeList. As in
+ * recognizeTokens the intern table is cleared after every line, so that it does not grow with
+ * the number of lines.
+ */
+
+void eqn_classify_batch(eqn_context *ctx, const char **lines, size_t n, eqn_result *out) {
+  RecogContext *rc = &ctx->recog;
+  Equation *eq = &rc->eq;
+  EquationKind kind;
+  List tl;
+  size_t i;
+  ctx->nroots = 0;
+  for (i = 0; i < n; i++) {
+    tl = scanLine(&rc->scanner, (char *)lines[i], strlen(lines[i]));
+    kind = classifyEquation(tl, rc);
+    out[i].cls = EQN_NOT_EQUATION;
+    out[i].degree = 0;
+    out[i].nvars = 0;
+    out[i].overflow = 0;
+    out[i].nsolutions = 0;
+    out[i].solutions = NULL;
+    out[i].toohigh = 0;
+    if (kind != NoEquation) {
+      out[i].cls = (kind == Equation1Var ? EQN_EQUATION_1VAR : EQN_EQUATION);
+      out[i].degree = eq->degree;
+      out[i].nvars = eq->vars.count;
+      out[i].overflow = eq->vars.overflow;
+    }
+    if (kind == Equation1Var) {
+      out[i].toohigh = (eq->degree > MAXDEGREE);
+      out[i].nsolutions = eq->nroots;
+      if (eq->nroots > 0) {
+        out[i].solutions = keepRoots(ctx, eq->roots, eq->nroots, out, i);
+      }
+    }
+    resetArena(&rc->arena);
+    clearInternTable(&rc->intern);
+  }
+}
+
+/* The function eqn_evaluate_batch stores in out[i] what kind of expression lines[i] is and
+ * its value, as eval prints it, with the values given by eqn_bind.
+ */
+
+void eqn_evaluate_batch(eqn_context *ctx, const char **lines, size_t n, eqn_value *out) {
+  static const eqn_kind kinds[] = {
+    EQN_NOT_EXPRESSION, EQN_ARITHMETICAL, EQN_BOUND, EQN_NUMERICAL
+  };
+  EvalContext *ec = &ctx->eval;
+  List tl;
+  double w;
+  size_t i;
+  for (i = 0; i < n; i++) {
+    tl = scanLine(&ec->scanner, (char *)lines[i], strlen(lines[i]));
+    w = 0;
+    out[i].kind = kinds[classifyExpression(tl, ec, &w)];
+    out[i].value = w;
+    resetArena(&ec->arena);
+  }
+}
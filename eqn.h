@@ -0,0 +1,62 @@
+/* eqn.h, the library interface of the equation recognizer and the expression evaluator
+ *
+ * libeqn.a offers the work of recog and eval without their dialogues: whole batches of lines
+ * are classified or evaluated, and the results are stored in arrays of the caller. All state
+ * is kept in an eqn_context, which is reused for every call, so once its buffers have grown to
+ * the size of the lines no more memory is allocated. Different contexts may be used
+ * concurrently, one per thread.
+ */
+
+#ifndef EQN_H
+#define EQN_H
+
+#include <stddef.h> /* size_t */
+
+typedef struct eqn_context eqn_context;
+
+typedef enum eqn_class {
+  EQN_NOT_EQUATION,
+  EQN_EQUATION,      /* an equation, but not in 1 variable */
+  EQN_EQUATION_1VAR  /* an equation in 1 variable, with its degree and real solutions */
+} eqn_class;
+
+/* The result of eqn_classify_batch for one line: nvars is the number of variables of an
+ * equation, of which at most 8 are kept; when there are more, overflow is set and nvars is 8.
+ * solutions[0..nsolutions-1] are the real solutions of an equation in 1 variable in ascending
+ * order. They point into the context and stay valid until its next call. toohigh is set when
+ * the degree is too high for the solver, whose solutions are then not computed.
+ */
+
+typedef struct eqn_result {
+  eqn_class cls;
+  int degree;
+  int nvars;
+  int overflow;
+  int nsolutions;
+  const double *solutions;
+  int toohigh;
+} eqn_result;
+
+typedef enum eqn_kind {
+  EQN_NOT_EXPRESSION,
+  EQN_ARITHMETICAL, /* an expression with identifiers that do not all have a value */
+  EQN_BOUND,        /* an expression whose identifiers all have a value, see eqn_bind */
+  EQN_NUMERICAL     /* an expression of numbers only */
+} eqn_kind;
+
+/* The result of eqn_evaluate_batch for one line; value is only set for EQN_BOUND and
+ * EQN_NUMERICAL.
+ */
+
+typedef struct eqn_value {
+  eqn_kind kind;
+  double value;
+} eqn_value;
+
+eqn_context *eqn_create(void);
+void eqn_destroy(eqn_context *ctx);
+void eqn_bind(eqn_context *ctx, const char *name, double value);
+void eqn_classify_batch(eqn_context *ctx, const char **lines, size_t n, eqn_result *out);
+void eqn_evaluate_batch(eqn_context *ctx, const char **lines, size_t n, eqn_value *out);
+
+#endif
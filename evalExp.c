@@ -18,10 +18,15 @@
  */
 
 #include <stdio.h>  /* getchar, printf */
-#include <stdlib.h> /* NULL */
+#include <stdlib.h> /* NULL, realloc, free */
+#include <string.h> /* strlen */
+#include <assert.h> /* assert */
 #include "scanner.h"
-#include "recognizeExp.h"
+#include "input.h"
+#include "recognizeEq.h"
+#include "bytecode.h"
 #include "evalExp.h"
+#include "instrument.h"
 
 /* The function valueNumber is an extension of acceptNumber: the second parameter
  * is a pointer. After successful execution it refers to the numerical value
@@ -30,7 +35,7 @@
 
 int valueNumber(List *lp, double *wp) {
   if (*lp != NULL && (*lp)->tt == Number) {
-    *wp = ((*lp)->t).number;
+    *wp = numberValue(*lp);
     *lp = (*lp)->next;
     return 1;
   }
@@ -45,10 +50,17 @@ int valueNumber(List *lp, double *wp) {
  */
 
 int valueFactor(List *lp, double *wp) {
-  return valueNumber(lp, wp) ||
-         (acceptCharacter(lp, '(') &&
-          valueExpression(lp, wp) &&
-          acceptCharacter(lp, ')'));
+  int ok;
+  if (valueNumber(lp, wp)) {
+    return 1;
+  }
+  if (!acceptCharacter(lp, '(')) {
+    return 0;
+  }
+  DEPTH_ENTER();
+  ok = valueExpression(lp, wp) && acceptCharacter(lp, ')');
+  DEPTH_LEAVE();
+  return ok;
 }
 
 int valueTerm(List *lp, double *wp) {
@@ -107,37 +119,437 @@ int valueExpression(List *lp, double *wp) {
   return 1;
 }
 
-/* The function evaluateExpressions performs a dialogue with the user, which
- * demonstrates the recognizer and the evaluator.
+/* The function valueExpressionStack yields the same as valueExpression, for the same grammar,
+ * but it needs no recursion: it is a shunting-yard parser with the explicit stack st, on which
+ * the values of the operands and the pending operators and open parentheses are kept. An
+ * operator first applies the pending operators of the same or higher precedence, so the
+ * operations are done in the same order as by valueExpression, with the same result.
+ * Deeply nested parentheses only make the stack grow on the heap, instead of the C stack.
+ * valueExpressionExact does the same with the fractions of rational.h, which are kept on the
+ * stack next to the doubles.
  */
 
-void evaluateExpressions() {
-  char *ar;
-  List tl, tl1;
+void initEvalStack(EvalStack *st) {
+  st->values = NULL;
+  st->exact = NULL;
+  st->ops = NULL;
+  st->capacity = 0;
+}
+
+void freeEvalStack(EvalStack *st) {
+  free(st->values);
+  free(st->exact);
+  free(st->ops);
+  initEvalStack(st);
+}
+
+static void growEvalStack(EvalStack *st) {
+  st->capacity = (st->capacity == 0 ? MAXINPUT : 2 * st->capacity);
+  st->values = realloc(st->values, st->capacity * sizeof(double));
+  st->exact = realloc(st->exact, st->capacity * sizeof(Rational));
+  st->ops = realloc(st->ops, st->capacity * sizeof(char));
+  assert(st->values != NULL && st->exact != NULL && st->ops != NULL);
+}
+
+/* The function reduce applies the topmost operator to the two topmost values, which are
+ * fractions when exact is set.
+ */
+
+static int reduce(EvalStack *st, int nvalues, int nops, int exact) {
+  double *v = st->values + nvalues - 2;
+  Rational *q = st->exact + nvalues - 2;
+  if (exact) {
+    switch (st->ops[nops - 1]) {
+    case '+':
+      q[0] = addRational(q[0], q[1]);
+      break;
+    case '-':
+      q[0] = subRational(q[0], q[1]);
+      break;
+    case '*':
+      q[0] = mulRational(q[0], q[1]);
+      break;
+    default:
+      q[0] = divRational(q[0], q[1]);
+      break;
+    }
+    return nvalues - 1;
+  }
+  switch (st->ops[nops - 1]) {
+  case '+':
+    v[0] = v[0] + v[1];
+    break;
+  case '-':
+    v[0] = v[0] - v[1];
+    break;
+  case '*':
+    v[0] = v[0] * v[1];
+    break;
+  default:
+    v[0] = v[0] / v[1];
+    break;
+  }
+  return nvalues - 1;
+}
+
+/* The function shunt is the parser of valueExpressionStack and valueExpressionExact; it
+ * leaves the value in st->values[0], or in st->exact[0] when exact is set.
+ */
+
+static int shunt(List *lp, EvalStack *st, int exact) {
+  List l = *lp;
+  int nvalues = 0, nops = 0, depth = 0, maxDepth = 0;
+  char op;
+  for (;;) {
+    /* an operand: open parentheses, then a number */
+    while (l != NULL && l->tt == Symbol && (l->t).symbol == '(') {
+      if (nops == st->capacity) {
+        growEvalStack(st);
+      }
+      st->ops[nops++] = '(';
+      depth++;
+      l = l->next;
+    }
+    if (l == NULL || l->tt != Number) {
+      return 0;
+    }
+    if (nvalues == st->capacity) {
+      growEvalStack(st);
+    }
+    if (exact) {
+      st->exact[nvalues++] = numberRational(l);
+    } else {
+      st->values[nvalues++] = numberValue(l);
+    }
+    l = l->next;
+    /* closing parentheses, then an operator or the end of the expression */
+    op = (l != NULL && l->tt == Symbol ? (l->t).symbol : '\0');
+    while (op == ')' && depth > 0) {
+      while (st->ops[nops - 1] != '(') {
+        nvalues = reduce(st, nvalues, nops--, exact);
+      }
+      nops--;
+      maxDepth = (depth > maxDepth ? depth : maxDepth);
+      depth--;
+      l = l->next;
+      op = (l != NULL && l->tt == Symbol ? (l->t).symbol : '\0');
+    }
+    if (op == '*' || op == '/') {
+      while (nops > 0 && (st->ops[nops - 1] == '*' || st->ops[nops - 1] == '/')) {
+        nvalues = reduce(st, nvalues, nops--, exact);
+      }
+    } else if (op == '+' || op == '-') {
+      while (nops > 0 && st->ops[nops - 1] != '(') {
+        nvalues = reduce(st, nvalues, nops--, exact);
+      }
+    } else { /* the end of the expression; a '(' without ')' is an error */
+      if (depth > 0) {
+        return 0;
+      }
+      while (nops > 0) {
+        nvalues = reduce(st, nvalues, nops--, exact);
+      }
+      DEPTH_REACHED(maxDepth);
+      *lp = l;
+      return 1;
+    }
+    if (nops == st->capacity) {
+      growEvalStack(st);
+    }
+    st->ops[nops++] = op;
+    l = l->next;
+  }
+}
+
+int valueExpressionStack(List *lp, double *wp, EvalStack *st) {
+  if (!shunt(lp, st, 0)) {
+    return 0;
+  }
+  *wp = st->values[0];
+  return 1;
+}
+
+/* The function valueExpressionExact stores the exact value of the expression in *rp, which is
+ * not a rational (den == 0) when the computation overflows or divides by 0; then the caller
+ * promotes the expression to valueExpressionStack.
+ */
+
+int valueExpressionExact(List *lp, Rational *rp, EvalStack *st) {
+  if (!shunt(lp, st, 1)) {
+    return 0;
+  }
+  *rp = st->exact[0];
+  return 1;
+}
+
+/* The functions valueNumberC, valueFactorC, valueTermC and valueExpressionC are the
+ * versions of the functions above for a token array: they take a cursor instead of a
+ * pointer to a token list.
+ */
+
+int valueNumberC(Cursor *cp, double *wp) {
+  if (cp->pos < cp->length && cp->tt[cp->pos] == Number) {
+    *wp = cursorNumber(cp);
+    cp->pos++;
+    return 1;
+  }
+  return 0;
+}
+
+int valueFactorC(Cursor *cp, double *wp) {
+  return valueNumberC(cp, wp) ||
+         (acceptCharacterC(cp, '(') &&
+          valueExpressionC(cp, wp) &&
+          acceptCharacterC(cp, ')'));
+}
+
+int valueTermC(Cursor *cp, double *wp) {
   double w;
-  printf("give an expression: ");
-  ar = readInput();
-  while (ar[0] != '!') {
-    tl = tokenList(ar);
-    printf("\nthe token list is ");
-    printList(tl);
-    tl1 = tl;
-    if (valueExpression(&tl1, &w) && tl1 == NULL) {
-      /* there may be no tokens left */
-      printf("this is a numerical expression with value %g\n", w);
+  if (!valueFactorC(cp, wp)) {
+    return 0;
+  }
+  w = *wp;
+  while (cp->pos < cp->length) {
+    if (acceptCharacterC(cp, '*')) {
+      if (valueFactorC(cp, wp)) {
+        w = w * (*wp);
+      } else {
+        return 0;
+      }
+    } else if (acceptCharacterC(cp, '/')) {
+      if (valueFactorC(cp, wp)) {
+        w = w / (*wp);
+      } else {
+        return 0;
+      }
     } else {
-      tl1 = tl;
-      if (acceptExpression(&tl1) && tl1 == NULL) {
-        printf("this is an arithmetical expression\n");
+      *wp = w;
+      return 1;
+    }
+  }
+  *wp = w;
+  return 1;
+}
+
+int valueExpressionC(Cursor *cp, double *wp) {
+  double w;
+  if (!valueTermC(cp, wp)) {
+    return 0;
+  }
+  w = *wp;
+  while (cp->pos < cp->length) {
+    if (acceptCharacterC(cp, '+')) {
+      if (valueTermC(cp, wp)) {
+        w = w + (*wp);
       } else {
-        printf("this is not an expression\n");
+        return 0;
+      }
+    } else if (acceptCharacterC(cp, '-')) {
+      if (valueTermC(cp, wp)) {
+        w = w - (*wp);
+      } else {
+        return 0;
       }
+    } else {
+      *wp = w;
+      return 1;
     }
+  }
+  *wp = w;
+  return 1;
+}
+
+/* The function classifyExpression yields what kind of expression the token list tl is, and
+ * stores its value in *wp when it has one. The value of a numerical expression is computed with
+ * valueExpressionStack, so deep nesting does no harm. Other expressions are recognized by
+ * building their tree with ab, for the same grammar with identifiers as factors. When ctx has
+ * bindings b, an expression with identifiers that all have a value in b is then compiled into
+ * the program p and run.
+ */
+
+ExpressionKind classifyExpression(List tl, EvalContext *ctx, double *wp) {
+  Bindings *b = ctx->b;
+  AstBuilder *ab = &ctx->ab;
+  Program *p = &ctx->p;
+  List tl1 = tl;
+  const double *args;
+  Node *root;
+  if (valueExpressionStack(&tl1, wp, &ctx->st) && tl1 == NULL) {
+    /* there may be no tokens left */
+    return NumericalExpression;
+  }
+  tl1 = tl;
+  root = buildExpression(&tl1, ab);
+  if (root == NULL || tl1 != NULL) {
+    return NotExpression;
+  }
+  if (b != NULL) {
+    compileAst(root, ab, p);
+    args = bindProgram(b, p);
+    if (args != NULL) {
+      *wp = runProgram(p, args);
+      return BoundExpression;
+    }
+  }
+  return ArithmeticalExpression;
+}
+
+/* The function evaluateList prints on out what kind of expression the token list tl is,
+ * and its value when it has one, see classifyExpression. In exact mode the value of a
+ * numerical expression is printed as a fraction, unless it does not fit in one: then it is
+ * promoted to a double.
+ */
+
+void evaluateList(FILE *out, List tl, EvalContext *ctx) {
+  List tl1 = tl;
+  Rational q;
+  double w;
+  TIMER_START(TimeEvaluate);
+  if (ctx->exact && valueExpressionExact(&tl1, &q, &ctx->st) && tl1 == NULL && q.den != 0) {
+    fprintf(out, "this is a numerical expression with value ");
+    fprintRational(out, q);
+    fprintf(out, "\n");
+    TIMER_STOP(TimeEvaluate);
+    return;
+  }
+  switch (classifyExpression(tl, ctx, &w)) {
+  case NumericalExpression:
+    fprintf(out, "this is a numerical expression with value %g\n", w);
+    break;
+  case BoundExpression:
+    fprintf(out, "this is an arithmetical expression with value %g\n", w);
+    break;
+  case ArithmeticalExpression:
+    fprintf(out, "this is an arithmetical expression\n");
+    break;
+  case NotExpression:
+    fprintf(out, "this is not an expression\n");
+    break;
+  }
+  TIMER_STOP(TimeEvaluate);
+}
+
+/* The function initEvalContext prepares a context for use with the bindings b, which may be
+ * NULL. As with a RecogContext, the scanner refers to the arena in the context, so a context
+ * must not be moved or copied after initEvalContext.
+ */
+
+void initEvalContext(EvalContext *ctx, Bindings *b) {
+  initArena(&ctx->arena);
+  initScanner(&ctx->scanner, &ctx->arena);
+  ctx->scanner.views = 1;
+  initAstBuilder(&ctx->ab);
+  initProgram(&ctx->p);
+  initEvalStack(&ctx->st);
+  ctx->b = b;
+  ctx->cache = NULL;
+  ctx->exact = 0;
+}
+
+void freeEvalContext(EvalContext *ctx) {
+  freeArena(&ctx->arena);
+  freeAstBuilder(&ctx->ab);
+  freeProgram(&ctx->p);
+  freeEvalStack(&ctx->st);
+}
+
+static void answerExpression(FILE *out, List tl, void *ctx) {
+  evaluateList(out, tl, ctx);
+}
+
+/* The function evaluateTokens prints on out the token list tl and what kind of expression it
+ * is, from the cache of ctx when it has one. The list must be in the arena of ctx, which is
+ * reset afterwards.
+ */
+
+void evaluateTokens(FILE *out, EvalContext *ctx, List tl) {
+  fprintf(out, "the token list is ");
+  fprintList(out, tl);
+  if (ctx->cache != NULL) {
+    answerCached(ctx->cache, out, tl, answerExpression, ctx);
+  } else {
+    evaluateList(out, tl, ctx);
+  }
+  resetArena(&ctx->arena);
+}
+
+/* The function evaluateLine scans the line of the given length at ar, and then does what
+ * evaluateTokens does.
+ */
+
+void evaluateLine(FILE *out, EvalContext *ctx, char *ar, int length) {
+  evaluateTokens(out, ctx, scanLine(&ctx->scanner, ar, length));
+}
+
+/* The function evaluateExpressions performs a dialogue with the user, which
+ * demonstrates the recognizer and the evaluator. The bindings b, which may be NULL,
+ * give values to identifiers.
+ */
+
+void evaluateExpressions(Bindings *b) {
+  char *ar;
+  EvalContext ctx;
+  initEvalContext(&ctx, b);
+  printf("give an expression: ");
+  ar = readInput();
+  while (ar[0] != '!') {
+    printf("\n");
+    evaluateLine(stdout, &ctx, ar, strlen(ar));
     free(ar);
-    freeTokenList(tl);
     printf("\ngive an expression: ");
     ar = readInput();
   }
   free(ar);
+  freeEvalContext(&ctx);
+  printf("good bye\n");
+  INSTRUMENT_DUMP(stderr);
+}
+
+/* The function evaluateBatch evaluates the lines of the input in, and prints exactly what
+ * evaluateExpressions prints for the same input, or with exact set, what it prints in exact
+ * mode. See recognizeBatch in recognizeEq.c. It yields 0 when the output could not be written,
+ * and 1 otherwise.
+ */
+
+int evaluateBatch(Input *in, Bindings *b, Cache *cache, int exact) {
+  Line line;
+  EvalContext ctx;
+  initEvalContext(&ctx, b);
+  ctx.cache = cache;
+  ctx.exact = exact;
+  printf("give an expression: ");
+  while (nextLine(in, &line) && (line.length == 0 || line.start[0] != '!')) {
+    printf("\n");
+    evaluateLine(stdout, &ctx, line.start, line.length);
+    printf("\ngive an expression: ");
+  }
+  freeEvalContext(&ctx);
+  printf("good bye\n");
+  INSTRUMENT_DUMP(stderr);
+  return fflush(stdout) == 0 && !ferror(stdout);
+}
+
+/* The function evaluateTokenFile evaluates the lines of the token file tf, see tokenFile.h,
+ * and prints the same as evaluateBatch for the input from which tf was written, without
+ * scanning the lines. A token file keeps only the double of a decimal number, so in exact mode
+ * a value may differ from that of evaluateBatch, see numberRational. It yields 0 when the
+ * output could not be written, and 1 otherwise.
+ */
+
+int evaluateTokenFile(const TokenFile *tf, Bindings *b, Cache *cache, int exact) {
+  EvalContext ctx;
+  size_t i;
+  initEvalContext(&ctx, b);
+  ctx.cache = cache;
+  ctx.exact = exact;
+  printf("give an expression: ");
+  for (i = 0; i < tf->nlines; i++) {
+    printf("\n");
+    evaluateTokens(stdout, &ctx, tokenFileLine(tf, i, &ctx.arena));
+    printf("\ngive an expression: ");
+  }
+  freeEvalContext(&ctx);
   printf("good bye\n");
+  INSTRUMENT_DUMP(stderr);
+  return fflush(stdout) == 0 && !ferror(stdout);
 }
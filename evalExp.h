@@ -3,7 +3,73 @@
 #ifndef EVALEXP_H
 #define EVALEXP_H
 
+#include "tokenArray.h"
+#include "input.h"
+#include "bytecode.h"
+#include "ast.h"
+#include "cache.h"
+#include "tokenFile.h"
+#include "rational.h"
+
+/* The kinds of expressions that classifyExpression distinguishes: a numerical expression has
+ * only numbers, and a bound expression identifiers that all have a value in the bindings;
+ * both have a value. An arithmetical expression has identifiers without values.
+ */
+
+typedef enum ExpressionKind {
+  NotExpression,
+  ArithmeticalExpression,
+  BoundExpression,
+  NumericalExpression
+} ExpressionKind;
+
+/* An EvalStack is the stack of valueExpressionStack: values holds the values of the operands,
+ * exact those of valueExpressionExact, and ops the pending operators and open parentheses, all
+ * with room for capacity elements.
+ */
+
+typedef struct EvalStack {
+  double *values;
+  Rational *exact;
+  char *ops;
+  int capacity;
+} EvalStack;
+
+/* An EvalContext holds all state of one evaluator that is reused for every line: the arena and
+ * the scanner for the token lists, the tree builder and the program for expressions with
+ * identifiers, the stack for numerical expressions, and the bindings that give the identifiers
+ * their values, or NULL. When cache is not NULL, evaluateLine looks the answers up in it.
+ * When exact is set, numerical expressions are evaluated with fractions, see rational.h.
+ */
+
+typedef struct EvalContext {
+  Arena arena;
+  Scanner scanner;
+  AstBuilder ab;
+  Program p;
+  EvalStack st;
+  Bindings *b;
+  Cache *cache;
+  int exact;
+} EvalContext;
+
 int valueExpression(List *lp, double *wp);
-void evaluateExpressions();
+void initEvalStack(EvalStack *st);
+void freeEvalStack(EvalStack *st);
+int valueExpressionStack(List *lp, double *wp, EvalStack *st);
+int valueExpressionExact(List *lp, Rational *rp, EvalStack *st);
+int valueNumberC(Cursor *cp, double *wp);
+int valueFactorC(Cursor *cp, double *wp);
+int valueTermC(Cursor *cp, double *wp);
+int valueExpressionC(Cursor *cp, double *wp);
+void evaluateExpressions(Bindings *b);
+ExpressionKind classifyExpression(List tl, EvalContext *ctx, double *wp);
+void evaluateList(FILE *out, List tl, EvalContext *ctx);
+void initEvalContext(EvalContext *ctx, Bindings *b);
+void freeEvalContext(EvalContext *ctx);
+void evaluateTokens(FILE *out, EvalContext *ctx, List tl);
+void evaluateLine(FILE *out, EvalContext *ctx, char *ar, int length);
+int evaluateBatch(Input *in, Bindings *b, Cache *cache, int exact);
+int evaluateTokenFile(const TokenFile *tf, Bindings *b, Cache *cache, int exact);
 
 #endif
@@ -0,0 +1,152 @@
+/* genCorpus.c
+ *
+ * Generator of large inputs for the benchmarks. It writes lines of one kind on standard output:
+ *   short   many short equations in one or two variables, like 3x^2 - 4x + 1 = 2x - 7
+ *   long    equations of about 4000 terms each
+ *   deep    numerical expressions with parentheses nested 100 deep, like ((1 + 2) * 3)
+ *   idents  expressions and equations with many different identifiers
+ * The generator has a random generator of its own, so the same arguments give the same
+ * corpus on every system:
+ *   genCorpus kind [lines [seed]]
+ */
+
+#include <stdio.h>  /* printf, putchar, fprintf */
+#include <stdlib.h> /* atoi, strtoul */
+#include <string.h> /* strcmp */
+
+#define LONGTERMS 4000
+#define DEPTH 100
+#define NIDENTS 50000
+
+static unsigned long long state = 88172645463325252ULL;
+
+/* The function next is a xorshift generator; it yields a number from 0 to n-1. */
+
+static int next(int n) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return (int)(state % n);
+}
+
+static char sign() {
+  return (next(2) ? '+' : '-');
+}
+
+/* The function term writes a term such as 3x^2, 4y, x or 7. */
+
+static void term(const char *vars) {
+  int v = next(4);
+  int coef = next(20) + 1;
+  int degree = next(4);
+  if (v == 0) {
+    printf("%d", coef);
+    return;
+  }
+  if (coef > 1 || next(2)) {
+    printf("%d", coef);
+  }
+  putchar(vars[next(strlen(vars))]);
+  if (degree > 1) {
+    printf("^%d", degree);
+  }
+}
+
+static void side(int nterms, const char *vars) {
+  int i;
+  term(vars);
+  for (i = 1; i < nterms; i++) {
+    printf(" %c ", sign());
+    term(vars);
+  }
+}
+
+static void shortLine() {
+  const char *vars = (next(4) == 0 ? "xy" : "x");
+  side(next(5) + 1, vars);
+  printf(" = ");
+  side(next(3) + 1, vars);
+  putchar('\n');
+}
+
+static void longLine() {
+  side(LONGTERMS, "x");
+  printf(" = 0\n");
+}
+
+static void deepLine() {
+  static const char ops[] = "+-*/";
+  int i;
+  for (i = 0; i < DEPTH; i++) {
+    putchar('(');
+  }
+  printf("%d", next(9) + 1);
+  for (i = 0; i < DEPTH; i++) {
+    printf(" %c %d)", ops[next(4)], next(9) + 1);
+  }
+  putchar('\n');
+}
+
+/* The function identifier writes one of NIDENTS identifiers, made of a few letters and a
+ * number, such as rate417.
+ */
+
+static void identifier() {
+  static const char *stems[] = {"x", "y", "rate", "total", "alpha", "k", "node", "sum"};
+  int id = next(NIDENTS);
+  printf("%s%d", stems[id % 8], id / 8);
+}
+
+static void identsLine() {
+  int n = next(8) + 2;
+  int i;
+  identifier();
+  for (i = 1; i < n; i++) {
+    printf(" %c ", "+-*/"[next(4)]);
+    if (next(3) == 0) {
+      printf("%d", next(100));
+    } else {
+      identifier();
+    }
+  }
+  if (next(2)) {
+    printf(" = 0");
+  }
+  putchar('\n');
+}
+
+int main(int argc, char *argv[]) {
+  void (*line)();
+  int lines, defaultLines, i;
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s short|long|deep|idents [lines [seed]]\n", argv[0]);
+    return 1;
+  }
+  if (strcmp(argv[1], "short") == 0) {
+    line = shortLine;
+    defaultLines = 200000;
+  } else if (strcmp(argv[1], "long") == 0) {
+    line = longLine;
+    defaultLines = 200;
+  } else if (strcmp(argv[1], "deep") == 0) {
+    line = deepLine;
+    defaultLines = 10000;
+  } else if (strcmp(argv[1], "idents") == 0) {
+    line = identsLine;
+    defaultLines = 200000;
+  } else {
+    fprintf(stderr, "%s: unknown kind %s\n", argv[0], argv[1]);
+    return 1;
+  }
+  lines = (argc > 2 ? atoi(argv[2]) : defaultLines);
+  if (argc > 3) {
+    state = state ^ strtoul(argv[3], NULL, 10);
+    if (state == 0) { /* xorshift would stay 0 */
+      state = 1;
+    }
+  }
+  for (i = 0; i < lines; i++) {
+    line();
+  }
+  return 0;
+}
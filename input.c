@@ -0,0 +1,204 @@
+/* input.c
+ *
+ * In this file the batch input is defined that replaces readInput for large inputs.
+ * readInput reads a line with one getchar per character into a buffer of its own;
+ * here a regular file is mapped in memory with mmap, and other input (a pipe or a
+ * terminal) is read with read in blocks of INPUTBLOCK bytes. nextLine yields the
+ * lines as slices of the mapped file or of the block buffer.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* mmap, posix_madvise, fstat, read */
+
+#include <stdlib.h>   /* NULL, malloc, realloc, free */
+#include <string.h>   /* memchr, memmove */
+#include <errno.h>    /* errno, EINTR */
+#include <fcntl.h>    /* open */
+#include <unistd.h>   /* read, close */
+#include <sys/mman.h> /* mmap, munmap, posix_madvise */
+#include <sys/stat.h> /* fstat */
+#include <limits.h>   /* INT_MAX */
+#include <assert.h>   /* assert */
+#include "input.h"
+
+/* The function openInput opens the file with the given path, or standard input when
+ * path is NULL. It yields 1 on success and 0 when the file cannot be opened.
+ */
+
+int openInput(Input *in, const char *path) {
+  int fd = (path == NULL ? 0 : open(path, O_RDONLY));
+  if (fd < 0) {
+    return 0;
+  }
+  openInputFd(in, fd);
+  return 1;
+}
+
+/* The function openInputFd makes an input of the open file descriptor fd, e.g. a socket;
+ * closeInput closes it, unless it is standard input.
+ */
+
+void openInputFd(Input *in, int fd) {
+  struct stat st;
+  void *p;
+  in->fd = fd;
+  in->data = NULL;
+  in->size = 0;
+  in->pos = 0;
+  in->capacity = 0;
+  in->eof = 0;
+  if (fstat(in->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    if (st.st_size == 0) { /* nothing to map */
+      in->eof = 1;
+      return;
+    }
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, in->fd, 0);
+    if (p != MAP_FAILED) {
+      posix_madvise(p, st.st_size, POSIX_MADV_SEQUENTIAL);
+      in->data = p;
+      in->size = st.st_size;
+      in->eof = 1;
+      return;
+    }
+  } /* no regular file, or mmap failed: read in blocks */
+  in->capacity = INPUTBLOCK;
+  in->data = malloc(in->capacity);
+  assert(in->data != NULL);
+}
+
+/* The function fill moves the unread part of the buffer to its front and reads
+ * the next block behind it. When a single line does not fit, the buffer is doubled.
+ */
+
+static void fill(Input *in) {
+  ssize_t n;
+  memmove(in->data, in->data + in->pos, in->size - in->pos);
+  in->size = in->size - in->pos;
+  in->pos = 0;
+  if (in->size == in->capacity) {
+    in->capacity = 2 * in->capacity;
+    in->data = realloc(in->data, in->capacity);
+    assert(in->data != NULL);
+  }
+  do {
+    n = read(in->fd, in->data + in->size, in->capacity - in->size);
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0) {
+    in->eof = 1;
+  } else {
+    in->size = in->size + n;
+  }
+}
+
+/* The function nextLine yields 1 and sets line to the next line of the input, or yields 0
+ * when the input is exhausted. The last line need not end with '\n'. The slice stays valid
+ * until the next call of nextLine.
+ */
+
+int nextLine(Input *in, Line *line) {
+  char *nl;
+  for (;;) {
+    nl = (in->pos < in->size ? memchr(in->data + in->pos, '\n', in->size - in->pos) : NULL);
+    if (nl != NULL || (in->eof && in->pos < in->size)) {
+      line->start = in->data + in->pos;
+      line->length = (nl != NULL ? nl : in->data + in->size) - line->start;
+      in->pos = in->pos + line->length + (nl != NULL);
+      return 1;
+    }
+    if (in->eof) {
+      return 0;
+    }
+    fill(in);
+  }
+}
+
+/* The function nextChunk yields 1 and sets chunk to the next part of the input that consists
+ * of whole lines, including their '\n', and is about size bytes long: it ends at the last
+ * line end within size bytes, or, when a line is longer than that, at the end of that line.
+ * It yields 0 when the input is exhausted. Like a line, the chunk is valid until the next call.
+ */
+
+int nextChunk(Input *in, size_t size, Line *chunk) {
+  size_t end;
+  char *nl;
+  for (;;) {
+    if (in->size - in->pos >= size || in->eof) {
+      if (in->pos == in->size) {
+        return 0;
+      }
+      end = (in->size - in->pos > size ? in->pos + size : in->size);
+      if (end < in->size || !in->eof) { /* find the last line end before end */
+        while (end > in->pos && in->data[end - 1] != '\n') {
+          end--;
+        }
+        if (end == in->pos) { /* a long line: take all of it */
+          nl = memchr(in->data + in->pos, '\n', in->size - in->pos);
+          if (nl != NULL) {
+            end = nl + 1 - in->data;
+          } else if (in->eof) {
+            end = in->size;
+          } else {
+            fill(in);
+            continue;
+          }
+        }
+      }
+      assert(end - in->pos <= INT_MAX);
+      chunk->start = in->data + in->pos;
+      chunk->length = end - in->pos;
+      in->pos = end;
+      return 1;
+    }
+    fill(in);
+  }
+}
+
+/* The function nextBatch yields 1 and sets batch to the whole lines, including their '\n', that
+ * have arrived so far, at most about size bytes of them, as nextChunk does. Unlike nextChunk it
+ * does not wait for more input when at least one line is complete, so on a pipe or a socket a
+ * batch is what the other side has sent, and an answer can be given before more is sent.
+ * It yields 0 when the input is exhausted.
+ */
+
+int nextBatch(Input *in, size_t size, Line *batch) {
+  size_t end;
+  char *nl;
+  for (;;) {
+    end = (in->size - in->pos > size ? in->pos + size : in->size);
+    while (end > in->pos && in->data[end - 1] != '\n') {
+      end--;
+    }
+    if (end == in->pos && in->pos < in->size) { /* a long line, or a last line without '\n' */
+      nl = memchr(in->data + in->pos, '\n', in->size - in->pos);
+      if (nl != NULL) {
+        end = nl + 1 - in->data;
+      } else if (in->eof) {
+        end = in->size;
+      }
+    }
+    if (end > in->pos) {
+      assert(end - in->pos <= INT_MAX);
+      batch->start = in->data + in->pos;
+      batch->length = end - in->pos;
+      in->pos = end;
+      return 1;
+    }
+    if (in->eof) {
+      return 0;
+    }
+    fill(in);
+  }
+}
+
+void closeInput(Input *in) {
+  if (in->capacity == 0) {
+    if (in->data != NULL) {
+      munmap(in->data, in->size);
+    }
+  } else {
+    free(in->data);
+  }
+  if (in->fd != 0) {
+    close(in->fd);
+  }
+  in->data = NULL;
+}
@@ -0,0 +1,40 @@
+/* input.h, batch input of lines from a file or from standard input */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h> /* size_t */
+
+#define INPUTBLOCK (1 << 20) /* size of the blocks in which a pipe is read */
+
+/* A line is a slice of the input: it starts at start and has length characters,
+ * without the '\n'. It is not terminated by '\0'.
+ */
+
+typedef struct Line {
+  char *start;
+  int length;
+} Line;
+
+/* An input is either a regular file that is mapped in memory as a whole, or a pipe that
+ * is read in large blocks into a buffer. In both cases the lines are handed out as slices
+ * of data, so no line is copied or allocated on its own.
+ */
+
+typedef struct Input {
+  int fd;
+  char *data;
+  size_t size;     /* number of bytes in data */
+  size_t pos;      /* start of the next line in data */
+  size_t capacity; /* size of the buffer; 0 when the file is mapped */
+  int eof;
+} Input;
+
+int openInput(Input *in, const char *path);
+void openInputFd(Input *in, int fd);
+int nextLine(Input *in, Line *line);
+int nextChunk(Input *in, size_t size, Line *chunk);
+int nextBatch(Input *in, size_t size, Line *batch);
+void closeInput(Input *in);
+
+#endif
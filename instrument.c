@@ -0,0 +1,46 @@
+/* instrument.c
+ *
+ * In this file the global instrument of instrument.h is defined, with the clock of the timers
+ * and the summary. It is linked into every program, but it is only used in a build with
+ * -DINSTRUMENT.
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <stdio.h> /* fprintf */
+#include <time.h>  /* clock_gettime */
+#include "instrument.h"
+
+Instrument instrument;
+
+static const char *counterNames[NCOUNTERS] = {
+  "tokens scanned", "nodes allocated", "identifiers allocated", "bytes realloc'd"
+};
+
+static const char *timerNames[NTIMERS] = {
+  "readInput", "scanLine", "recognizeList", "evaluateList"
+};
+
+/* The function instrumentNow yields the time of a monotonic clock in nanoseconds. */
+
+long long instrumentNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void dumpInstrument(FILE *out) {
+  int i;
+  fprintf(out, "instrumentation:\n");
+  if (instrument.off) {
+    fprintf(out, "  off with --jobs\n");
+    return;
+  }
+  for (i = 0; i < NCOUNTERS; i++) {
+    fprintf(out, "  %-24s %lld\n", counterNames[i], instrument.counts[i]);
+  }
+  fprintf(out, "  %-24s %d\n", "deepest parentheses", instrument.maxDepth);
+  for (i = 0; i < NTIMERS; i++) {
+    fprintf(out, "  %-24s %.3f ms\n", timerNames[i], instrument.ns[i] / 1e6);
+  }
+}
@@ -0,0 +1,78 @@
+/* instrument.h, counters and timers for the hot paths */
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdio.h> /* FILE */
+
+/* When the program is built with -DINSTRUMENT, the macros below count events and measure the
+ * time spent in the stages of the programs in the global instrument, and INSTRUMENT_DUMP
+ * prints a summary, e.g. when the dialogue ends at '!'. Otherwise the macros expand to
+ * nothing, so they cost nothing. The instrument cannot be shared by threads: the counters
+ * would race, and TIMER_STOP needs the start of its own TIMER_START. So recognizeParallel
+ * turns it off as a whole with off, and with --jobs nothing is reported.
+ */
+
+typedef enum Counter {
+  CountTokens,       /* tokens scanned, into lists and token arrays */
+  CountNodes,        /* list nodes allocated */
+  CountIdentifiers,  /* identifier strings allocated */
+  CountReallocBytes, /* bytes requested by realloc in readInput and matchIdentifier */
+  NCOUNTERS
+} Counter;
+
+typedef enum Timer {
+  TimeRead,      /* readInput */
+  TimeScan,      /* scanLine */
+  TimeRecognize, /* recognizeList */
+  TimeEvaluate,  /* evaluateList */
+  NTIMERS
+} Timer;
+
+/* depth is the current depth of the recursive calls of valueExpression by valueFactor, i.e. of
+ * the parentheses, and maxDepth the deepest one so far, also of those of valueExpressionStack,
+ * which reports it with DEPTH_REACHED; start[s] is the time at which the current run of timer
+ * s started, and ns[s] the total time of timer s in nanoseconds. When off is set, the macros
+ * do nothing.
+ */
+
+typedef struct Instrument {
+  long long counts[NCOUNTERS];
+  long long ns[NTIMERS];
+  long long start[NTIMERS];
+  int depth;
+  int maxDepth;
+  int off;
+} Instrument;
+
+extern Instrument instrument;
+
+long long instrumentNow();
+void dumpInstrument(FILE *out);
+
+#ifdef INSTRUMENT
+#define COUNT(c, n) (instrument.off ? (void)0 : (void)(instrument.counts[c] += (n)))
+#define TIMER_START(s) \
+  (instrument.off ? (void)0 : (void)(instrument.start[s] = instrumentNow()))
+#define TIMER_STOP(s) \
+  (instrument.off ? (void)0 \
+                  : (void)(instrument.ns[s] += instrumentNow() - instrument.start[s]))
+#define DEPTH_ENTER() \
+  (instrument.off || ++instrument.depth <= instrument.maxDepth \
+       ? (void)0 \
+       : (void)(instrument.maxDepth = instrument.depth))
+#define DEPTH_LEAVE() (instrument.off ? (void)0 : (void)instrument.depth--)
+#define DEPTH_REACHED(d) \
+  (instrument.off || (d) <= instrument.maxDepth ? (void)0 : (void)(instrument.maxDepth = (d)))
+#define INSTRUMENT_DUMP(out) dumpInstrument(out)
+#else
+#define COUNT(c, n) ((void)0)
+#define TIMER_START(s) ((void)0)
+#define TIMER_STOP(s) ((void)0)
+#define DEPTH_ENTER() ((void)0)
+#define DEPTH_LEAVE() ((void)0)
+#define DEPTH_REACHED(d) ((void)0)
+#define INSTRUMENT_DUMP(out) ((void)0)
+#endif
+
+#endif
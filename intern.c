@@ -0,0 +1,207 @@
+/* intern.c
+ *
+ * In this file the intern table is defined. The scanner uses it to give every identifier
+ * an id at scan time, so that the recognizer can compare identifiers with one integer
+ * comparison instead of strcmp.
+ */
+
+#include <stdlib.h> /* NULL, malloc, realloc, free */
+#include <string.h> /* memcmp, memcpy */
+#include <assert.h> /* assert */
+#include "intern.h"
+
+#define INITSLOTS 64 /* initial number of slots in the hash table */
+
+void initInternTable(InternTable *t) {
+  t->slots = NULL;
+  t->nslots = 0;
+  t->count = 0;
+  t->offset = NULL;
+  t->length = NULL;
+  t->hash = NULL;
+  t->idCapacity = 0;
+  t->names = NULL;
+  t->namesLength = 0;
+  t->namesCapacity = 0;
+}
+
+/* The function hashName computes the FNV-1a hash of the length characters at s.
+ */
+
+static unsigned hashName(const char *s, int length) {
+  unsigned h = 2166136261u;
+  int i;
+  for (i = 0; i < length; i++) {
+    h = (h ^ (unsigned char)s[i]) * 16777619u;
+  }
+  return h;
+}
+
+/* The function rehash makes a hash table with nslots slots and puts all ids in it.
+ */
+
+static void rehash(InternTable *t, int nslots) {
+  int i, j;
+  free(t->slots);
+  t->slots = malloc(nslots * sizeof(int));
+  assert(t->slots != NULL);
+  t->nslots = nslots;
+  for (i = 0; i < nslots; i++) {
+    t->slots[i] = -1;
+  }
+  for (i = 0; i < t->count; i++) {
+    j = t->hash[i] & (nslots - 1);
+    while (t->slots[j] >= 0) {
+      j = (j + 1) & (nslots - 1);
+    }
+    t->slots[j] = i;
+  }
+}
+
+/* The function addName stores a new name in the table and yields its id.
+ */
+
+static int addName(InternTable *t, const char *s, int length, unsigned h) {
+  int id = t->count;
+  if (id == t->idCapacity) {
+    t->idCapacity = (t->idCapacity == 0 ? INITSLOTS / 2 : 2 * t->idCapacity);
+    t->offset = realloc(t->offset, t->idCapacity * sizeof(int));
+    t->length = realloc(t->length, t->idCapacity * sizeof(int));
+    t->hash = realloc(t->hash, t->idCapacity * sizeof(unsigned));
+    assert(t->offset != NULL && t->length != NULL && t->hash != NULL);
+  }
+  while (t->namesLength + length + 1 > t->namesCapacity) {
+    t->namesCapacity = (t->namesCapacity == 0 ? 256 : 2 * t->namesCapacity);
+    t->names = realloc(t->names, t->namesCapacity);
+    assert(t->names != NULL);
+  }
+  memcpy(t->names + t->namesLength, s, length);
+  t->names[t->namesLength + length] = '\0';
+  t->offset[id] = t->namesLength;
+  t->length[id] = length;
+  t->hash[id] = h;
+  t->namesLength = t->namesLength + length + 1;
+  t->count++;
+  return id;
+}
+
+/* The function internIdentifier yields the id of the identifier of the given length at s,
+ * which need not be terminated by '\0'. A new identifier gets the next free id.
+ * The hash table is kept at most half full.
+ */
+
+int internIdentifier(InternTable *t, const char *s, int length) {
+  unsigned h = hashName(s, length);
+  int j, id;
+  if (2 * (t->count + 1) > t->nslots) {
+    rehash(t, t->nslots == 0 ? INITSLOTS : 2 * t->nslots);
+  }
+  j = h & (t->nslots - 1);
+  while ((id = t->slots[j]) >= 0) {
+    if (t->hash[id] == h && t->length[id] == length &&
+        memcmp(t->names + t->offset[id], s, length) == 0) {
+      return id;
+    }
+    j = (j + 1) & (t->nslots - 1);
+  }
+  id = addName(t, s, length, h);
+  t->slots[j] = id;
+  return id;
+}
+
+/* The function findIdentifier yields the id of an identifier like internIdentifier, but
+ * yields -1 instead of adding it when it is not in the table.
+ */
+
+int findIdentifier(InternTable *t, const char *s, int length) {
+  unsigned h;
+  int j, id;
+  if (t->nslots == 0) {
+    return -1;
+  }
+  h = hashName(s, length);
+  j = h & (t->nslots - 1);
+  while ((id = t->slots[j]) >= 0) {
+    if (t->hash[id] == h && t->length[id] == length &&
+        memcmp(t->names + t->offset[id], s, length) == 0) {
+      return id;
+    }
+    j = (j + 1) & (t->nslots - 1);
+  }
+  return -1;
+}
+
+/* The function identifierName yields the name of an id, terminated by '\0'.
+ */
+
+const char *identifierName(InternTable *t, int id) {
+  return t->names + t->offset[id];
+}
+
+/* The function clearInternTable forgets all ids, but keeps the memory of the table. The
+ * recognizers clear their table after every line, so when there are few ids only their own
+ * slots are emptied, which are found by probing as in internIdentifier, and not the whole
+ * table, which may have grown large for one line with many identifiers.
+ */
+
+void clearInternTable(InternTable *t) {
+  int i, j;
+  if (4 * t->count < t->nslots) {
+    for (i = 0; i < t->count; i++) {
+      j = t->hash[i] & (t->nslots - 1);
+      while (t->slots[j] != i) {
+        j = (j + 1) & (t->nslots - 1);
+      }
+      t->slots[j] = -1;
+    }
+  } else {
+    for (i = 0; i < t->nslots; i++) {
+      t->slots[i] = -1;
+    }
+  }
+  t->count = 0;
+  t->namesLength = 0;
+}
+
+void freeInternTable(InternTable *t) {
+  free(t->slots);
+  free(t->offset);
+  free(t->length);
+  free(t->hash);
+  free(t->names);
+  initInternTable(t);
+}
+
+void clearVarSet(VarSet *vs) {
+  vs->bits = 0;
+  vs->count = 0;
+  vs->overflow = 0;
+}
+
+/* The function addVariable adds the variable id with the exponent degree to the set,
+ * or raises its degree when it is already in the set.
+ */
+
+void addVariable(VarSet *vs, int id, int degree) {
+  int i;
+  if (id >= 64 || (vs->bits >> id & 1)) { /* the variable may be in the set already */
+    for (i = 0; i < vs->count; i++) {
+      if (vs->id[i] == id) {
+        if (degree > vs->degree[i]) {
+          vs->degree[i] = degree;
+        }
+        return;
+      }
+    }
+  }
+  if (vs->count == MAXVARS) {
+    vs->overflow = 1;
+    return;
+  }
+  if (id < 64) {
+    vs->bits |= 1ULL << id;
+  }
+  vs->id[vs->count] = id;
+  vs->degree[vs->count] = degree;
+  vs->count++;
+}
@@ -0,0 +1,50 @@
+/* intern.h, table that gives every distinct identifier a small integer id */
+
+#ifndef INTERN_H
+#define INTERN_H
+
+/* An intern table maps identifiers to the ids 0, 1, 2, ... in the order in which they are
+ * first seen. The names are copied into the table, so the ids stay valid when the lines in
+ * which the identifiers occurred have been released.
+ */
+
+typedef struct InternTable {
+  int *slots;     /* open addressing hash table of ids, -1 for an empty slot */
+  int nslots;     /* a power of two */
+  int count;      /* number of ids */
+  int *offset;    /* offset[id] is the offset of the name of id in names */
+  int *length;    /* length[id] is the length of that name */
+  unsigned *hash; /* hash[id] is the hash of that name */
+  int idCapacity;
+  char *names;    /* the names, each terminated by '\0' */
+  int namesLength;
+  int namesCapacity;
+} InternTable;
+
+void initInternTable(InternTable *t);
+int internIdentifier(InternTable *t, const char *s, int length);
+int findIdentifier(InternTable *t, const char *s, int length);
+const char *identifierName(InternTable *t, int id);
+void clearInternTable(InternTable *t);
+void freeInternTable(InternTable *t);
+
+/* A variable set is a small set of identifier ids, together with the highest exponent
+ * with which each of them occurs. Ids below 64 are also kept in a bitset, so that the
+ * membership test for them is a single bit test. At most MAXVARS variables are kept;
+ * when there are more, overflow is set.
+ */
+
+#define MAXVARS 8
+
+typedef struct VarSet {
+  unsigned long long bits;
+  int count;
+  int overflow;
+  int id[MAXVARS];
+  int degree[MAXVARS];
+} VarSet;
+
+void clearVarSet(VarSet *vs);
+void addVariable(VarSet *vs, int id, int degree);
+
+#endif
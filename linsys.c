@@ -0,0 +1,345 @@
+/* linsys.c
+ *
+ * In this file the linear systems of linsys.h are collected and solved. A system is solved by
+ * an LU factorization with partial pivoting, PA = LU, which is blocked as in LAPACK's dgetrf:
+ * a panel of LUBLOCK columns is factorized on its own, the rows of U to the right of it are
+ * computed, and only then is the trailing matrix updated with all LUBLOCK columns at once, in
+ * strips of GEMMBLOCK columns. The panel and the strip of U stay in the cache while every row
+ * of the trailing matrix streams past them once, instead of once per column as in plain
+ * Gaussian elimination. The matrix is stored by rows, so all inner loops run along a row, and
+ * the trailing rows are updated four at a time, so that every element of U loaded from the
+ * cache is used four times. See benchLinsys.c.
+ */
+
+#include <stdlib.h> /* NULL, malloc, realloc, free */
+#include <string.h> /* memset, memcpy */
+#include <math.h>   /* fabs */
+#include <float.h>  /* DBL_EPSILON */
+#include <assert.h> /* assert */
+#include "poly.h"
+#include "linsys.h"
+
+#define RESIDUAL 1e-9 /* relative residual above which an equation counts as not satisfied */
+
+void initLinearSystem(LinearSystem *s) {
+  s->entries = NULL;
+  s->nentries = 0;
+  s->entriesCapacity = 0;
+  s->rhs = NULL;
+  s->rows = 0;
+  s->rowsCapacity = 0;
+  s->vars = NULL;
+  s->cols = 0;
+  s->varsCapacity = 0;
+  s->column = NULL;
+  s->columnCapacity = 0;
+  s->a = NULL;
+  s->b = NULL;
+  s->bCapacity = 0;
+  s->x = NULL;
+  s->piv = NULL;
+  s->xCapacity = 0;
+  s->capacity = 0;
+}
+
+void freeLinearSystem(LinearSystem *s) {
+  free(s->entries);
+  free(s->rhs);
+  free(s->vars);
+  free(s->column);
+  free(s->a);
+  free(s->b);
+  free(s->x);
+  free(s->piv);
+  initLinearSystem(s);
+}
+
+/* The function clearLinearSystem empties the system for the next block; only the columns of
+ * its own variables are reset, so the cost does not depend on the number of identifiers.
+ */
+
+void clearLinearSystem(LinearSystem *s) {
+  int c;
+  for (c = 0; c < s->cols; c++) {
+    s->column[s->vars[c]] = -1;
+  }
+  s->nentries = 0;
+  s->rows = 0;
+  s->cols = 0;
+}
+
+/* The function grow makes room for n elements of the given size in the array *p with room for
+ * *capacity elements, by doubling it, as in readInput.
+ */
+
+static void grow(void **p, int *capacity, int n, size_t size) {
+  if (n <= *capacity) {
+    return;
+  }
+  *capacity = (*capacity == 0 ? 16 : *capacity);
+  while (n > *capacity) {
+    *capacity = 2 * *capacity;
+  }
+  *p = realloc(*p, *capacity * size);
+  assert(*p != NULL);
+}
+
+/* The function columnOf yields the column of the variable id, and gives it a new column when
+ * it has none yet.
+ */
+
+static int columnOf(LinearSystem *s, int id) {
+  int old = s->columnCapacity;
+  int i;
+  grow((void **)&s->column, &s->columnCapacity, id + 1, sizeof(int));
+  for (i = old; i < s->columnCapacity; i++) {
+    s->column[i] = -1;
+  }
+  if (s->column[id] < 0) {
+    grow((void **)&s->vars, &s->varsCapacity, s->cols + 1, sizeof(int));
+    s->vars[s->cols] = id;
+    s->column[id] = s->cols++;
+  }
+  return s->column[id];
+}
+
+/* The function addEquationRow adds the equation with the normal form p = 0 as a row. It yields
+ * 1, or 0 when the equation is not linear; then the system is left as it was.
+ */
+
+int addEquationRow(LinearSystem *s, const Poly *p) {
+  const Monomial *m;
+  const Monomial *end = p->terms + p->count;
+  Triplet *t;
+  for (m = p->terms; m < end; m++) {
+    if (m->coef != 0 && m->degree > 1) {
+      return 0;
+    }
+  }
+  grow((void **)&s->rhs, &s->rowsCapacity, s->rows + 1, sizeof(double));
+  s->rhs[s->rows] = 0;
+  for (m = p->terms; m < end; m++) {
+    if (m->coef == 0) {
+      continue;
+    }
+    if (m->var < 0) {
+      s->rhs[s->rows] = -m->coef;
+    } else {
+      grow((void **)&s->entries, &s->entriesCapacity, s->nentries + 1, sizeof(Triplet));
+      t = &s->entries[s->nentries++];
+      t->row = s->rows;
+      t->col = columnOf(s, m->var);
+      t->value = m->coef;
+    }
+  }
+  s->rows++;
+  return 1;
+}
+
+static void swapRows(double *a, int cols, int i, int j) {
+  double *p = a + (size_t)i * cols;
+  double *q = a + (size_t)j * cols;
+  double t;
+  int c;
+  for (c = 0; c < cols; c++) {
+    t = p[c];
+    p[c] = q[c];
+    q[c] = t;
+  }
+}
+
+/* The function factorPanel factorizes the columns k..k+kb-1 of the rows k..rows-1 with partial
+ * pivoting; the rows are swapped as a whole, so the columns outside the panel follow. It yields
+ * 0 when a pivot is not above tol.
+ */
+
+static int factorPanel(double *a, int rows, int cols, int k, int kb, int *piv, double tol) {
+  double *pivotRow, *row;
+  double l, best;
+  int i, j, c, p;
+  for (j = k; j < k + kb; j++) {
+    p = j;
+    best = fabs(a[(size_t)j * cols + j]);
+    for (i = j + 1; i < rows; i++) {
+      if (fabs(a[(size_t)i * cols + j]) > best) {
+        best = fabs(a[(size_t)i * cols + j]);
+        p = i;
+      }
+    }
+    if (best <= tol) {
+      return 0;
+    }
+    piv[j] = p;
+    if (p != j) {
+      swapRows(a, cols, j, p);
+    }
+    pivotRow = a + (size_t)j * cols;
+    for (i = j + 1; i < rows; i++) {
+      row = a + (size_t)i * cols;
+      l = row[j] / pivotRow[j];
+      row[j] = l;
+      for (c = j + 1; c < k + kb; c++) {
+        row[c] -= l * pivotRow[c];
+      }
+    }
+  }
+  return 1;
+}
+
+/* The function updateRows4 subtracts L21 U12 from four consecutive rows at r of the trailing
+ * matrix, in the columns jj..je-1; uk is row k, the first row of U12. Every element of U12
+ * that is loaded is used for all four rows.
+ */
+
+static void updateRows4(double *r, int cols, const double *uk, int k, int kb, int jj, int je) {
+  double *restrict r0 = r, *restrict r1 = r + cols;
+  double *restrict r2 = r + 2 * (size_t)cols, *restrict r3 = r + 3 * (size_t)cols;
+  const double *restrict u;
+  double l0, l1, l2, l3, v;
+  int p, c;
+  for (p = k; p < k + kb; p++) {
+    u = uk + (size_t)(p - k) * cols;
+    l0 = r0[p];
+    l1 = r1[p];
+    l2 = r2[p];
+    l3 = r3[p];
+    for (c = jj; c < je; c++) {
+      v = u[c];
+      r0[c] -= l0 * v;
+      r1[c] -= l1 * v;
+      r2[c] -= l2 * v;
+      r3[c] -= l3 * v;
+    }
+  }
+}
+
+/* The function luFactor computes PA = LU in place for the matrix a with rows >= cols, stored
+ * by rows: U is on and above the diagonal, L, whose diagonal is 1, below it, and row j was
+ * swapped with row piv[j] in step j. It yields 1, or 0 when a has not full column rank, i.e. a
+ * pivot is not above tol.
+ */
+
+int luFactor(double *a, int rows, int cols, int *piv, double tol) {
+  double *restrict row;
+  const double *restrict u;
+  double l;
+  int k, kb, i, j, p, c, jj, je;
+  for (k = 0; k < cols; k += LUBLOCK) {
+    kb = (cols - k < LUBLOCK ? cols - k : LUBLOCK);
+    if (!factorPanel(a, rows, cols, k, kb, piv, tol)) {
+      return 0;
+    }
+    /* the rows of U right of the panel: solve L11 U12 = A12 */
+    for (j = k; j < k + kb; j++) {
+      u = a + (size_t)j * cols;
+      for (i = j + 1; i < k + kb; i++) {
+        row = a + (size_t)i * cols;
+        l = row[j];
+        for (c = k + kb; c < cols; c++) {
+          row[c] -= l * u[c];
+        }
+      }
+    }
+    /* the trailing matrix: A22 = A22 - L21 U12, a strip of columns at a time */
+    for (jj = k + kb; jj < cols; jj += GEMMBLOCK) {
+      je = (cols - jj < GEMMBLOCK ? cols : jj + GEMMBLOCK);
+      for (i = k + kb; i + 4 <= rows; i += 4) {
+        updateRows4(a + (size_t)i * cols, cols, a + (size_t)k * cols, k, kb, jj, je);
+      }
+      for (; i < rows; i++) {
+        row = a + (size_t)i * cols;
+        for (p = k; p < k + kb; p++) {
+          l = row[p];
+          u = a + (size_t)p * cols;
+          for (c = jj; c < je; c++) {
+            row[c] -= l * u[c];
+          }
+        }
+      }
+    }
+  }
+  return 1;
+}
+
+/* The function luSolve solves Ax = b with the factorization of luFactor: b has rows elements,
+ * where rows >= cols, and the solution is left in b[0..cols-1]. The swaps of the pivots may
+ * move any row of b into the first cols ones, so b is permuted as a whole.
+ */
+
+void luSolve(const double *a, int rows, int cols, const int *piv, double *b) {
+  double t;
+  int i, j;
+  assert(rows >= cols);
+  for (j = 0; j < cols; j++) {
+    if (piv[j] != j) {
+      t = b[j];
+      b[j] = b[piv[j]];
+      b[piv[j]] = t;
+    }
+  }
+  for (i = 1; i < cols; i++) {
+    for (j = 0; j < i; j++) {
+      b[i] -= a[(size_t)i * cols + j] * b[j];
+    }
+  }
+  for (i = cols - 1; i >= 0; i--) {
+    for (j = i + 1; j < cols; j++) {
+      b[i] -= a[(size_t)i * cols + j] * b[j];
+    }
+    b[i] = b[i] / a[(size_t)i * cols + i];
+  }
+}
+
+/* The function solveLinearSystem yields 1 when the system has a unique solution, which is
+ * then in x[0..cols-1], and 0 otherwise. A system with more equations than variables has a
+ * solution when the solution of its first independent equations satisfies the others too, up
+ * to a residual of RESIDUAL relative to the size of the terms of the equation.
+ */
+
+int solveLinearSystem(LinearSystem *s) {
+  size_t size = (size_t)s->rows * s->cols;
+  double norm = 0;
+  double *scale;
+  Triplet *t, *end = s->entries + s->nentries;
+  int r, pivCapacity;
+  if (s->cols == 0 || s->rows < s->cols) {
+    return 0;
+  }
+  if (size > s->capacity) {
+    s->capacity = size;
+    free(s->a);
+    s->a = malloc(size * sizeof(double));
+    assert(s->a != NULL);
+  }
+  grow((void **)&s->b, &s->bCapacity, s->rows, sizeof(double));
+  pivCapacity = s->xCapacity;
+  grow((void **)&s->x, &s->xCapacity, s->cols, sizeof(double));
+  grow((void **)&s->piv, &pivCapacity, s->cols, sizeof(int));
+  memset(s->a, 0, size * sizeof(double));
+  for (t = s->entries; t < end; t++) {
+    s->a[(size_t)t->row * s->cols + t->col] = t->value;
+    norm = (fabs(t->value) > norm ? fabs(t->value) : norm);
+  }
+  if (!luFactor(s->a, s->rows, s->cols, s->piv, norm * s->rows * DBL_EPSILON)) {
+    return 0;
+  }
+  memcpy(s->b, s->rhs, s->rows * sizeof(double));
+  luSolve(s->a, s->rows, s->cols, s->piv, s->b);
+  memcpy(s->x, s->b, s->cols * sizeof(double));
+  /* the residuals of all equations in b, and the sizes of their terms in a, which is free now */
+  scale = s->a;
+  for (r = 0; r < s->rows; r++) {
+    s->b[r] = -s->rhs[r];
+    scale[r] = fabs(s->rhs[r]);
+  }
+  for (t = s->entries; t < end; t++) {
+    s->b[t->row] += t->value * s->x[t->col];
+    scale[t->row] += fabs(t->value * s->x[t->col]);
+  }
+  for (r = 0; r < s->rows; r++) {
+    if (fabs(s->b[r]) > RESIDUAL * scale[r]) {
+      return 0;
+    }
+  }
+  return 1;
+}
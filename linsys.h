@@ -0,0 +1,56 @@
+/* linsys.h, systems of linear equations in several variables */
+
+#ifndef LINSYS_H
+#define LINSYS_H
+
+#include "poly.h"
+
+#define LUBLOCK 64    /* width of the panels of luFactor */
+#define GEMMBLOCK 256 /* number of columns of the trailing matrix that luFactor updates at once */
+
+/* A LinearSystem collects the equations of a block, each in the normal form of parseEquation,
+ * as rows of a matrix: the coefficients of row r are the triplets with row r, where col is
+ * the column of a variable, and rhs[r] is minus the constant term. The columns are numbered in
+ * the order in which the variables first occur: vars[c] is the identifier id of column c, and
+ * column[id] is the column of id, or -1. solveLinearSystem puts the equations in the dense
+ * matrix a, with rows rows and cols columns, and solves them into x; b is the right hand side
+ * that luSolve works on, and piv the pivots of luFactor. All arrays are reused for the next
+ * block.
+ */
+
+typedef struct Triplet {
+  int row;
+  int col;
+  double value;
+} Triplet;
+
+typedef struct LinearSystem {
+  Triplet *entries;
+  int nentries;
+  int entriesCapacity;
+  double *rhs;
+  int rows;
+  int rowsCapacity;
+  int *vars;
+  int cols;
+  int varsCapacity;
+  int *column;
+  int columnCapacity;
+  double *a;
+  size_t capacity;
+  double *b;
+  int bCapacity;
+  double *x;
+  int *piv;
+  int xCapacity; /* the capacity of x and of piv */
+} LinearSystem;
+
+void initLinearSystem(LinearSystem *s);
+void clearLinearSystem(LinearSystem *s);
+int addEquationRow(LinearSystem *s, const Poly *p);
+int solveLinearSystem(LinearSystem *s);
+void freeLinearSystem(LinearSystem *s);
+int luFactor(double *a, int rows, int cols, int *piv, double tol);
+void luSolve(const double *a, int rows, int cols, const int *piv, double *b);
+
+#endif
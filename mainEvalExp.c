@@ -2,10 +2,103 @@
 #include <stdio.h>
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 #include "scanner.h"
 #include "evalExp.h"
+#include "server.h"
+
+/* Without arguments the program is the dialogue evaluateExpressions.
+ * With -b it runs in batch mode on the given file, or on standard input.
+ * Every option -D name=value gives the identifier name a value:
+ *   eval [-D name=value ...] [-b [file]]
+ * With --serve it is a server without prompts, see mainRecog.c:
+ *   eval [-D name=value ...] --serve [socket]
+ * With -t it reads a token file that scan -w has written instead of scanning the lines:
+ *   eval [-D name=value ...] -t file
+ * The option --cache m keeps the answers in an LRU cache of m megabytes with -b, -t and
+ * --serve, as in recog, and so does --exact, which evaluates numerical expressions with exact
+ * fractions, see rational.h:
+ *   eval [--cache m] [--exact] [-D name=value ...] -b [file]
+ */
+
+static void serveLine(FILE *out, char *ar, int length, void *state) {
+  evaluateLine(out, state, ar, length);
+  fprintf(out, "\n");
+}
 
 int main(int argc, char *argv[]) {
-  evaluateExpressions();
+  Input in;
+  TokenFile tf;
+  Bindings b;
+  EvalContext ctx;
+  Cache cache;
+  Cache *cp = NULL;
+  char *eq;
+  int arg = 1;
+  int exact = 0;
+  int ok = 1;
+  int mb;
+  initBindings(&b);
+  while (arg + 1 < argc && strcmp(argv[arg], "--cache") == 0) {
+    mb = atoi(argv[arg + 1]);
+    if (mb < 1 || cp != NULL) {
+      fprintf(stderr, "%s: --cache needs a size in megabytes\n", argv[0]);
+      return 1;
+    }
+    initCache(&cache, (size_t)mb << 20);
+    cp = &cache;
+    arg += 2;
+  }
+  if (argc > arg && strcmp(argv[arg], "--exact") == 0) {
+    exact = 1;
+    arg++;
+  }
+  while (arg + 1 < argc && strcmp(argv[arg], "-D") == 0) {
+    eq = strchr(argv[arg + 1], '=');
+    if (eq == NULL) {
+      fprintf(stderr, "%s: -D needs name=value\n", argv[0]);
+      return 1;
+    }
+    bindVariable(&b, argv[arg + 1], eq - argv[arg + 1], atof(eq + 1));
+    arg += 2;
+  }
+  if (argc > arg && strcmp(argv[arg], "--serve") == 0) {
+    initEvalContext(&ctx, b.names.count > 0 ? &b : NULL);
+    ctx.cache = cp;
+    ctx.exact = exact;
+    if (!serve(argc > arg + 1 ? argv[arg + 1] : NULL, serveLine, &ctx)) {
+      perror(argv[arg + 1]);
+      return 1;
+    }
+    freeEvalContext(&ctx);
+  } else if (argc > arg && strcmp(argv[arg], "-b") == 0) {
+    if (!openInput(&in, argc > arg + 1 ? argv[arg + 1] : NULL)) {
+      perror(argv[arg + 1]);
+      return 1;
+    }
+    ok = evaluateBatch(&in, b.names.count > 0 ? &b : NULL, cp, exact);
+    closeInput(&in);
+  } else if (argc > arg + 1 && strcmp(argv[arg], "-t") == 0) {
+    if (!openTokenFile(&tf, argv[arg + 1])) {
+      perror(argv[arg + 1]);
+      return 1;
+    }
+    ok = evaluateTokenFile(&tf, b.names.count > 0 ? &b : NULL, cp, exact);
+    closeTokenFile(&tf);
+  } else if (cp != NULL || exact) {
+    fprintf(stderr, "%s: --cache and --exact work with -b, -t and --serve only\n", argv[0]);
+    return 1;
+  } else {
+    evaluateExpressions(b.names.count > 0 ? &b : NULL);
+  }
+  if (cp != NULL) {
+    printCacheStats(stderr, cp);
+    freeCache(cp);
+  }
+  freeBindings(&b);
+  if (!ok) {
+    fprintf(stderr, "%s: the output could not be written\n", argv[0]);
+    return 1;
+  }
   return 0;
 }
@@ -1,11 +1,166 @@
+#define _POSIX_C_SOURCE 200112L /* open, close */
+
 #include <stdlib.h> 
 #include <stdio.h>
 #include <assert.h>
 #include <math.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "scanner.h"
 #include "recognizeEq.h"
+#include "parallel.h"
+#include "server.h"
+
+/* Without arguments the program is the dialogue recognizeEquations.
+ * With -b it runs in batch mode on the given file, or on standard input, and with --jobs
+ * it does the same with n threads:
+ *   recog -b [file]
+ *   recog --jobs n [file]
+ * With --stream it reads the file, or standard input, as it arrives, without waiting for whole
+ * lines, which suits a pipe or a socket:
+ *   recog --stream [file]
+ * With --serve it is a server without prompts, on standard input or on a Unix socket, that
+ * answers every line with what recog -b prints for it, followed by an empty line:
+ *   recog --serve [socket]
+ * With -t it reads a token file that scan -w has written, see tokenFile.h, and prints what
+ * recog -b prints for the lines from which it was written, without scanning them:
+ *   recog -t file
+ * With --system it reads blocks of equations that are separated by empty lines, and solves
+ * each block as a system of linear equations in several variables:
+ *   recog --system [file]
+ * A leading --cache m keeps the answers to the lines in an LRU cache of m megabytes, see cache.h,
+ * and prints its statistics on standard error at the end; it works with -b, -t and --serve:
+ *   recog --cache m -b [file]
+ *   recog --cache m --serve [socket]
+ * A leading --exact, after --cache m if that is given, prints the solutions of linear equations
+ * as exact fractions, like -1/3, see rational.h; it works with -b, -t and --serve too:
+ *   recog [--cache m] --exact -b [file]
+ * A leading --format tsv or --format json, after --exact if that is given, prints one record
+ * per line instead of the dialogue, with the line number, the kind, the degree and the
+ * solutions, see recognizeBatch; it works with -b and -t, and not with --cache:
+ *   recog [--exact] --format tsv|json -b [file]
+ */
+
+static void serveLine(FILE *out, char *ar, int length, void *state) {
+  recognizeLine(out, state, ar, length);
+  fprintf(out, "\n");
+}
 
 int main(int argc, char *argv[]) {
-  recognizeEquations();
+  Input in;
+  TokenFile tf;
+  RecogContext ctx;
+  Cache cache;
+  Cache *cp = NULL;
+  char *name = argv[0];
+  int jobs = 0;
+  int exact = 0;
+  OutputFormat format = FormatText;
+  int arg = 2;
+  int ok = 1;
+  int fd, mb;
+  if (argc > 2 && strcmp(argv[1], "--cache") == 0) {
+    mb = atoi(argv[2]);
+    if (mb < 1) {
+      fprintf(stderr, "%s: --cache needs a size in megabytes\n", name);
+      return 1;
+    }
+    initCache(&cache, (size_t)mb << 20);
+    cp = &cache;
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc > 1 && strcmp(argv[1], "--exact") == 0) {
+    exact = 1;
+    argc--;
+    argv++;
+  }
+  if (argc > 1 && strcmp(argv[1], "--format") == 0) {
+    if (argc > 2 && strcmp(argv[2], "tsv") == 0) {
+      format = FormatTsv;
+    } else if (argc > 2 && strcmp(argv[2], "json") == 0) {
+      format = FormatJson;
+    } else {
+      fprintf(stderr, "%s: --format needs tsv or json\n", name);
+      return 1;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc > 1 && strcmp(argv[1], "--jobs") == 0) {
+    jobs = (argc > 2 ? atoi(argv[2]) : 0);
+    if (jobs < 1 || jobs > MAXJOBS) {
+      fprintf(stderr, "%s: --jobs needs a number from 1 to %d\n", name, MAXJOBS);
+      return 1;
+    }
+    arg = 3;
+  }
+  if ((cp != NULL || exact) && (jobs > 1 || argc < 2 ||
+                                (strcmp(argv[1], "-b") != 0 && strcmp(argv[1], "-t") != 0 &&
+                                 strcmp(argv[1], "--serve") != 0 && jobs == 0))) {
+    fprintf(stderr, "%s: --cache and --exact work with -b, -t and --serve only\n", name);
+    return 1;
+  }
+  if (format != FormatText && (cp != NULL || argc < 2 ||
+                               (strcmp(argv[1], "-b") != 0 && strcmp(argv[1], "-t") != 0))) {
+    fprintf(stderr, "%s: --format works with -b and -t only, and not with --cache\n", name);
+    return 1;
+  }
+  if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+    initRecogContext(&ctx);
+    ctx.cache = cp;
+    ctx.exact = exact;
+    if (!serve(argc > 2 ? argv[2] : NULL, serveLine, &ctx)) {
+      perror(argv[2]);
+      return 1;
+    }
+    freeRecogContext(&ctx);
+  } else if (argc > 1 && strcmp(argv[1], "--stream") == 0) {
+    fd = (argc > 2 ? open(argv[2], O_RDONLY) : 0);
+    if (fd < 0) {
+      perror(argv[2]);
+      return 1;
+    }
+    recognizeStream(fd);
+    if (fd != 0) {
+      close(fd);
+    }
+  } else if (argc > 1 && strcmp(argv[1], "--system") == 0) {
+    if (!openInput(&in, argc > 2 ? argv[2] : NULL)) {
+      perror(argv[2]);
+      return 1;
+    }
+    recognizeSystems(&in);
+    closeInput(&in);
+  } else if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+    if (!openTokenFile(&tf, argv[2])) {
+      perror(argv[2]);
+      return 1;
+    }
+    ok = recognizeTokenFile(&tf, cp, exact, format);
+    closeTokenFile(&tf);
+  } else if (jobs > 0 || (argc > 1 && strcmp(argv[1], "-b") == 0)) {
+    if (!openInput(&in, argc > arg ? argv[arg] : NULL)) {
+      perror(argv[arg]);
+      return 1;
+    }
+    if (jobs > 1) {
+      ok = recognizeParallel(&in, jobs);
+    } else {
+      ok = recognizeBatch(&in, cp, exact, format);
+    }
+    closeInput(&in);
+  } else {
+    recognizeEquations();
+  }
+  if (cp != NULL) {
+    printCacheStats(stderr, cp);
+    freeCache(cp);
+  }
+  if (!ok) {
+    fprintf(stderr, "%s: the output could not be written\n", name);
+    return 1;
+  }
   return 0;
-}
\ No newline at end of file
+}
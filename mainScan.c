@@ -1,6 +1,29 @@
+#include <stdio.h>
+#include <string.h>
 #include "scanner.h"
+#include "input.h"
+#include "tokenFile.h"
+
+/* Without arguments the program is the dialogue scanExpressions.
+ * With -w it scans the lines of the given file, or of standard input, and writes their token
+ * lists to the token file out, see tokenFile.h, which recog -t and eval -t read:
+ *   scan -w out [file]
+ */
 
 int main(int argc, char *argv[]) {
+  Input in;
+  if (argc > 2 && strcmp(argv[1], "-w") == 0) {
+    if (!openInput(&in, argc > 3 ? argv[3] : NULL)) {
+      perror(argv[3]);
+      return 1;
+    }
+    if (!writeTokenFile(&in, argv[2])) {
+      perror(argv[2]);
+      return 1;
+    }
+    closeInput(&in);
+    return 0;
+  }
   scanExpressions();
   return 0;
 }
@@ -0,0 +1,135 @@
+/* parallel.c
+ *
+ * In this file the multi-threaded batch mode of the recognizer is defined.
+ * The input is cut into chunks of whole lines of about CHUNKSIZE bytes. In every round each of
+ * the jobs threads recognizes one chunk with recognizeLine, using a RecogContext (and so an
+ * arena and a scanner) of its own, and writes its output into a memory stream. The outputs are
+ * then written in the order of the chunks, so the result is exactly what recognizeBatch
+ * prints for the same input.
+ */
+
+#define _POSIX_C_SOURCE 200809L /* open_memstream */
+
+#include <stdio.h>   /* printf, fwrite, open_memstream */
+#include <stdlib.h>  /* NULL, malloc, realloc, free */
+#include <string.h>  /* memchr, memcpy */
+#include <pthread.h> /* pthread_create, pthread_join */
+#include <assert.h>  /* assert */
+#include "scanner.h"
+#include "recognizeEq.h"
+#include "parallel.h"
+#include "instrument.h"
+
+/* A job is the work of one thread in a round: the chunk it recognizes, with a copy of it
+ * when the input is not mapped in memory, its context, and its output.
+ */
+
+typedef struct Job {
+  char *data;
+  int length;
+  char *copy;
+  int copyCapacity;
+  RecogContext ctx;
+  char *out;
+  size_t outLength;
+  int stop; /* the chunk contains a line starting with '!' */
+  pthread_t thread;
+} Job;
+
+/* The function runJob recognizes the lines of the chunk of a job, up to a line that
+ * starts with '!'.
+ */
+
+static void *runJob(void *arg) {
+  Job *job = arg;
+  FILE *out = open_memstream(&job->out, &job->outLength);
+  char *p = job->data;
+  char *end = job->data + job->length;
+  char *nl;
+  int length;
+  assert(out != NULL);
+  job->stop = 0;
+  while (p < end) {
+    nl = memchr(p, '\n', end - p);
+    length = (nl != NULL ? nl : end) - p;
+    if (length > 0 && p[0] == '!') {
+      job->stop = 1;
+      break;
+    }
+    recognizeLine(out, &job->ctx, p, length);
+    fprintf(out, "\ngive an equation: ");
+    p = p + length + 1;
+  }
+  fclose(out);
+  return NULL;
+}
+
+/* The function startJob gives a chunk to a job and starts its thread. A chunk of an input
+ * that is read in blocks is copied first, because the next chunk may overwrite it.
+ */
+
+static void startJob(Job *job, Input *in, Line *chunk) {
+  int err;
+  if (in->capacity == 0) { /* the input is mapped, the chunk stays valid */
+    job->data = chunk->start;
+  } else {
+    if (chunk->length > job->copyCapacity) {
+      job->copyCapacity = chunk->length;
+      job->copy = realloc(job->copy, job->copyCapacity);
+      assert(job->copy != NULL);
+    }
+    memcpy(job->copy, chunk->start, chunk->length);
+    job->data = job->copy;
+  }
+  job->length = chunk->length;
+  err = pthread_create(&job->thread, NULL, runJob, job);
+  assert(err == 0);
+}
+
+/* The function recognizeParallel recognizes the lines of the input in with jobs threads.
+ * The instrument of instrument.h is turned off, since the threads would share it. It yields 0
+ * when the output could not be written, and 1 otherwise.
+ */
+
+int recognizeParallel(Input *in, int jobs) {
+  Job *job;
+  Line chunk;
+  int i, n;
+  int stop = 0;
+  assert(jobs >= 1 && jobs <= MAXJOBS);
+  job = malloc(jobs * sizeof(Job));
+  assert(job != NULL);
+  instrument.off = 1;
+  for (i = 0; i < jobs; i++) {
+    initRecogContext(&job[i].ctx);
+    job[i].copy = NULL;
+    job[i].copyCapacity = 0;
+  }
+  printf("give an equation: ");
+  while (!stop) {
+    n = 0;
+    while (n < jobs && nextChunk(in, CHUNKSIZE, &chunk)) {
+      startJob(&job[n], in, &chunk);
+      n++;
+    }
+    if (n == 0) { /* the end of the input */
+      break;
+    }
+    for (i = 0; i < n; i++) { /* the outputs are written in the order of the chunks */
+      pthread_join(job[i].thread, NULL);
+      if (!stop) {
+        fwrite(job[i].out, 1, job[i].outLength, stdout);
+        stop = job[i].stop;
+      }
+      free(job[i].out);
+    }
+  }
+  printf("good bye\n");
+  INSTRUMENT_DUMP(stderr);
+  for (i = 0; i < jobs; i++) {
+    freeRecogContext(&job[i].ctx);
+    free(job[i].copy);
+  }
+  free(job);
+  return fflush(stdout) == 0 && !ferror(stdout);
+}
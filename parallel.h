@@ -0,0 +1,13 @@
+/* parallel.h, multi-threaded batch mode of the recognizer */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "input.h"
+
+#define CHUNKSIZE (1 << 20) /* size of the part of the input that one thread handles */
+#define MAXJOBS 256
+
+int recognizeParallel(Input *in, int jobs);
+
+#endif
@@ -0,0 +1,119 @@
+/* poly.c
+ *
+ * In this file sparse polynomials are defined. The recognizer collects the terms of an
+ * equation in a polynomial while it parses, so that like terms on both sides of '=' are
+ * combined and the degree can be taken from what remains.
+ */
+
+#include <stdlib.h> /* NULL, malloc, realloc, free */
+#include <assert.h> /* assert */
+#include "rational.h"
+#include "poly.h"
+
+#define INITSLOTS 16 /* initial number of slots in the hash table */
+
+void initPoly(Poly *p) {
+  p->terms = NULL;
+  p->count = 0;
+  p->capacity = 0;
+  p->slots = NULL;
+  p->nslots = 0;
+}
+
+static unsigned hashMonomial(int var, int degree) {
+  unsigned h = 2166136261u;
+  h = (h ^ (unsigned)var) * 16777619u;
+  h = (h ^ (unsigned)degree) * 16777619u;
+  return h ^ (h >> 15);
+}
+
+/* The function findSlot yields the slot of (var, degree), or the empty slot where it belongs.
+ */
+
+static int findSlot(Poly *p, int var, int degree) {
+  int mask = p->nslots - 1;
+  int s = hashMonomial(var, degree) & mask;
+  Monomial *m;
+  while (p->slots[s] >= 0) {
+    m = &p->terms[p->slots[s]];
+    if (m->var == var && m->degree == degree) {
+      return s;
+    }
+    s = (s + 1) & mask;
+  }
+  return s;
+}
+
+static void rehash(Poly *p, int nslots) {
+  int i;
+  free(p->slots);
+  p->slots = malloc(nslots * sizeof(int));
+  assert(p->slots != NULL);
+  p->nslots = nslots;
+  for (i = 0; i < nslots; i++) {
+    p->slots[i] = -1;
+  }
+  for (i = 0; i < p->count; i++) {
+    p->terms[i].slot = findSlot(p, p->terms[i].var, p->terms[i].degree);
+    p->slots[p->terms[i].slot] = i;
+  }
+}
+
+/* The function clearPoly empties the polynomial. Only the slots that are in use are emptied,
+ * so clearing costs as much as the monomials of the last equation, not the size of the table.
+ */
+
+void clearPoly(Poly *p) {
+  int i;
+  for (i = 0; i < p->count; i++) {
+    p->slots[p->terms[i].slot] = -1;
+  }
+  p->count = 0;
+}
+
+/* The function findMonomial yields the monomial var^degree of the polynomial; it is added with
+ * coefficient 0 when it is not there yet.
+ */
+
+static Monomial *findMonomial(Poly *p, int var, int degree) {
+  int s;
+  if (2 * (p->count + 1) > p->nslots) {
+    rehash(p, p->nslots == 0 ? INITSLOTS : 2 * p->nslots);
+  }
+  s = findSlot(p, var, degree);
+  if (p->slots[s] >= 0) {
+    return &p->terms[p->slots[s]];
+  }
+  if (p->count == p->capacity) {
+    p->capacity = (p->capacity == 0 ? 8 : 2 * p->capacity);
+    p->terms = realloc(p->terms, p->capacity * sizeof(Monomial));
+    assert(p->terms != NULL);
+  }
+  p->terms[p->count].var = var;
+  p->terms[p->count].degree = degree;
+  p->terms[p->count].coef = 0;
+  p->terms[p->count].exact = makeRational(0, 1);
+  p->terms[p->count].slot = s;
+  p->slots[s] = p->count;
+  return &p->terms[p->count++];
+}
+
+/* The function addMonomial adds c var^degree to the polynomial, and addMonomialExact also adds
+ * the same coefficient as the fraction q to the exact coefficient.
+ */
+
+void addMonomial(Poly *p, int var, int degree, double c) {
+  findMonomial(p, var, degree)->coef += c;
+}
+
+void addMonomialExact(Poly *p, int var, int degree, double c, Rational q) {
+  Monomial *m = findMonomial(p, var, degree);
+  m->coef += c;
+  m->exact = addRational(m->exact, q);
+}
+
+void freePoly(Poly *p) {
+  free(p->terms);
+  free(p->slots);
+  initPoly(p);
+}
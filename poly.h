@@ -0,0 +1,37 @@
+/* poly.h, sparse polynomials: a coefficient for every monomial that occurs */
+
+#ifndef POLY_H
+#define POLY_H
+
+#include "rational.h"
+
+/* A Monomial is var^degree with its coefficient; var is an identifier id, or -1 for the
+ * constant term, which has degree 0. A Poly holds the distinct monomials that have been added,
+ * in the order in which they were first added; monomials whose coefficients cancel stay in it
+ * with coefficient 0. The hash table slots maps (var, degree) to an index in terms.
+ * exact is the coefficient as a fraction, which is only kept up to date by addMonomialExact.
+ */
+
+typedef struct Monomial {
+  int var;
+  int degree;
+  double coef;
+  Rational exact;
+  int slot; /* the slot of the monomial in the hash table */
+} Monomial;
+
+typedef struct Poly {
+  Monomial *terms;
+  int count;
+  int capacity;
+  int *slots; /* open addressing hash table of indices in terms, -1 for an empty slot */
+  int nslots; /* a power of two */
+} Poly;
+
+void initPoly(Poly *p);
+void clearPoly(Poly *p);
+void addMonomial(Poly *p, int var, int degree, double c);
+void addMonomialExact(Poly *p, int var, int degree, double c, Rational q);
+void freePoly(Poly *p);
+
+#endif
@@ -0,0 +1,233 @@
+/* rational.c
+ *
+ * In this file the fractions of rational.h are defined. The operations follow Knuth (TAOCP
+ * vol. 2, 4.5.1): common factors are divided out before multiplying, so the intermediate
+ * results stay as small as the result and mostly need no gcd of their own. Every product and
+ * sum is checked for overflow; no memory is allocated.
+ */
+
+#include <stdio.h>  /* fprintf */
+#include <limits.h> /* LLONG_MAX, LLONG_MIN */
+#include <math.h>   /* floor, fabs */
+#include "scanner.h"
+#include "rational.h"
+
+static const Rational notRational = {0, 0};
+
+/* The functions mulOverflow and addOverflow store a * b and a + b in *r and yield 0, or yield 1
+ * when the result does not fit in a long long.
+ */
+
+static int mulOverflow(long long a, long long b, long long *r) {
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+  return __builtin_mul_overflow(a, b, r);
+#else
+  if (a != 0 && b != 0 &&
+      (a == LLONG_MIN || b == LLONG_MIN || (a < 0 ? -a : a) > LLONG_MAX / (b < 0 ? -b : b))) {
+    return 1;
+  }
+  *r = a * b;
+  return 0;
+#endif
+}
+
+static int addOverflow(long long a, long long b, long long *r) {
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+  return __builtin_add_overflow(a, b, r);
+#else
+  if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b)) {
+    return 1;
+  }
+  *r = a + b;
+  return 0;
+#endif
+}
+
+/* The function gcd yields the greatest common divisor of a >= 0 and b >= 0, with Euclid's
+ * algorithm; gcd(0, b) is b.
+ */
+
+static long long gcd(long long a, long long b) {
+  long long t;
+  while (b != 0) {
+    t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/* The function makeRational yields num/den in lowest terms. */
+
+Rational makeRational(long long num, long long den) {
+  Rational r;
+  long long g;
+  if (den == 0 || num == LLONG_MIN || den == LLONG_MIN) {
+    return notRational;
+  }
+  if (den < 0) {
+    num = -num;
+    den = -den;
+  }
+  g = gcd(num < 0 ? -num : num, den);
+  r.num = num / g;
+  r.den = den / g;
+  return r;
+}
+
+/* The function rationalOfDouble yields the simplest fraction that gives back w when it is
+ * divided out in double arithmetic, so that a decimal such as 0.1, which cannot be a double
+ * exactly, becomes 1/10. The candidates are the convergents of the continued fraction of w;
+ * they are computed in double arithmetic, but a candidate is only taken when it gives back w
+ * exactly. It is not a rational when no convergent with 64-bit terms does.
+ */
+
+Rational rationalOfDouble(double w) {
+  long long a, h, k, h1 = 1, h2 = 0, k1 = 0, k2 = 1;
+  double f = fabs(w);
+  double x = f;
+  int i;
+  if (!(f < 9223372036854775808.0)) { /* NaN, infinite or not below 2^63 */
+    return notRational;
+  }
+  if (f == floor(f)) {
+    return makeRational((long long)w, 1);
+  }
+  for (i = 0; i < 64; i++) {
+    a = (long long)floor(x);
+    if (mulOverflow(a, h1, &h) || addOverflow(h, h2, &h) ||
+        mulOverflow(a, k1, &k) || addOverflow(k, k2, &k)) {
+      return notRational;
+    }
+    if ((double)h / (double)k == f) {
+      return makeRational(w < 0 ? -h : h, k);
+    }
+    if (x == (double)a || (x = 1 / (x - a)) >= 9223372036854775808.0) {
+      return notRational;
+    }
+    h2 = h1;
+    h1 = h;
+    k2 = k1;
+    k1 = k;
+  }
+  return notRational;
+}
+
+/* The function literalRational yields the value of the number s[0..length-1], written as digits
+ * with at most one '.', as the fraction of its digits and a power of 10, e.g. 0.25 as 25/100,
+ * which is 1/4. It is not a rational when the digits or the power do not fit.
+ */
+
+static Rational literalRational(const char *s, int length) {
+  long long num = 0, den = 1;
+  int point = 0;
+  int i;
+  for (i = 0; i < length; i++) {
+    if (s[i] == '.') {
+      point = 1;
+    } else if (mulOverflow(num, 10, &num) || addOverflow(num, s[i] - '0', &num) ||
+               (point && mulOverflow(den, 10, &den))) {
+      return notRational;
+    }
+  }
+  return makeRational(num, den);
+}
+
+/* The function numberRational yields the value of a number token of any kind, as numberValue
+ * in scanner.c does for a double. A NumDecimal number is taken from its digits, so that it is
+ * exact: 0.3333333333333333 is 3333333333333333/10^16 and not 1/3. Only when its digits are
+ * not known, as for the tokens of a token file, it is the fraction that rationalOfDouble finds
+ * for the double, which may differ from the number as it was written.
+ */
+
+Rational numberRational(List l) {
+  const char *s;
+  switch (l->kind) {
+  case NumInt:
+    return makeRational((l->t).number, 1);
+  case NumLong:
+    return makeRational((l->t).wide, 1);
+  default:
+    s = numberLiteral(l);
+    return (s != NULL ? literalRational(s, l->length) : rationalOfDouble((l->t).decimal));
+  }
+}
+
+/* The function addRational yields a + b. Only the factor that the denominators have in common
+ * can divide the new numerator, so only that factor is tried.
+ */
+
+Rational addRational(Rational a, Rational b) {
+  Rational r;
+  long long g, s, t;
+  if (a.den == 0 || b.den == 0) {
+    return notRational;
+  }
+  if (a.den == 1 && b.den == 1) {
+    r.den = 1;
+    return (addOverflow(a.num, b.num, &r.num) || r.num == LLONG_MIN ? notRational : r);
+  }
+  g = gcd(a.den, b.den);
+  if (mulOverflow(a.num, b.den / g, &s) || mulOverflow(b.num, a.den / g, &t) ||
+      addOverflow(s, t, &t) || t == LLONG_MIN) {
+    return notRational;
+  }
+  s = gcd(t < 0 ? -t : t, g);
+  r.num = t / s;
+  if (mulOverflow(a.den / g, b.den / s, &r.den)) {
+    return notRational;
+  }
+  return r;
+}
+
+Rational subRational(Rational a, Rational b) {
+  b.num = -b.num;
+  return addRational(a, b);
+}
+
+/* The function mulRational yields a b. The numerator of a is coprime with its denominator, so
+ * dividing it by its gcd with the denominator of b, and vice versa, gives the result in lowest
+ * terms.
+ */
+
+Rational mulRational(Rational a, Rational b) {
+  Rational r;
+  long long g1, g2;
+  if (a.den == 0 || b.den == 0) {
+    return notRational;
+  }
+  if (a.num == 0 || b.num == 0) {
+    return makeRational(0, 1);
+  }
+  g1 = gcd(a.num < 0 ? -a.num : a.num, b.den);
+  g2 = gcd(b.num < 0 ? -b.num : b.num, a.den);
+  if (mulOverflow(a.num / g1, b.num / g2, &r.num) || r.num == LLONG_MIN ||
+      mulOverflow(a.den / g2, b.den / g1, &r.den)) {
+    return notRational;
+  }
+  return r;
+}
+
+Rational divRational(Rational a, Rational b) {
+  Rational inverse;
+  if (b.den == 0 || b.num == 0) {
+    return notRational;
+  }
+  inverse.num = (b.num < 0 ? -b.den : b.den);
+  inverse.den = (b.num < 0 ? -b.num : b.num);
+  return mulRational(a, inverse);
+}
+
+double rationalValue(Rational r) {
+  return (double)r.num / (double)r.den;
+}
+
+/* The function fprintRational prints r as an integer or as a fraction, like -1/3. */
+
+void fprintRational(FILE *out, Rational r) {
+  if (r.den == 1) {
+    fprintf(out, "%lld", r.num);
+  } else {
+    fprintf(out, "%lld/%lld", r.num, r.den);
+  }
+}
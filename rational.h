@@ -0,0 +1,31 @@
+/* rational.h, exact fractions of 64-bit integers */
+
+#ifndef RATIONAL_H
+#define RATIONAL_H
+
+#include <stdio.h> /* FILE */
+#include "scanner.h"
+
+/* A Rational is the fraction num/den in lowest terms, with den > 0 and num > LLONG_MIN, so
+ * that it can always be negated. A result that does not fit, like the quotient of a division
+ * by 0 or a product whose numerator needs more than 64 bits, has den == 0: it is not a
+ * rational, and every operation on it yields a non-rational again, so that a computation can
+ * be checked once at its end and then promoted to double arithmetic.
+ */
+
+typedef struct Rational {
+  long long num;
+  long long den;
+} Rational;
+
+Rational makeRational(long long num, long long den);
+Rational rationalOfDouble(double w);
+Rational numberRational(List l);
+Rational addRational(Rational a, Rational b);
+Rational subRational(Rational a, Rational b);
+Rational mulRational(Rational a, Rational b);
+Rational divRational(Rational a, Rational b);
+double rationalValue(Rational r);
+void fprintRational(FILE *out, Rational r);
+
+#endif
@@ -17,12 +17,23 @@
  * structure of the BNF grammar.
  */
 
+#define _POSIX_C_SOURCE 200112L /* read */
+
 #include <stdio.h>  /* getchar, printf */
 #include <stdlib.h> /* NULL */
 #include "scanner.h"
+#include "tokenArray.h"
+#include "input.h"
+#include "stream.h"
+#include "tokenFile.h"
+#include "writer.h"
 #include "recognizeEq.h"
+#include "instrument.h"
 #include <math.h>
 #include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
 
 /* The functions acceptNumber, acceptIdentifier and acceptCharacter have as
  * (first) argument a pointer to an token list; moreover acceptCharacter has as
@@ -61,56 +72,77 @@ int acceptCharacter(List *lp, char c) {
  * has an initial segment that can be recognized as factor, term or expression, respectively.
  * When that is the case, they yield the value 1 and the pointer points to the rest of
  * the token list. Otherwise they yield 0 and the pointer remains unchanged.
+ * All state of the recognizer is in the context ctx that is passed along, so several
+ * recognizers, each with a context of its own, can run at the same time.
  */
 
-// stores the biggest exponent
-int biggestExponent = - 1;
+/* The function initRecogContext prepares a context for use; it allocates nothing yet.
+ * The scanner of the context refers to the arena and the intern table in it, so a context
+ * must not be moved or copied after initRecogContext.
+ */
+void initRecogContext(RecogContext *ctx) {
+  ctx->biggestExponent = -1;
+  initArena(&ctx->arena);
+  initInternTable(&ctx->intern);
+  initScanner(&ctx->scanner, &ctx->arena);
+  ctx->scanner.views = 1;
+  ctx->scanner.intern = &ctx->intern;
+  initEquation(&ctx->eq);
+  ctx->cache = NULL;
+  ctx->exact = 0;
+}
 
-// reads the value of the number and determine whether it is biggest exponent
-int valueNumber(List *lp, double *wp) {
-  if (*lp != NULL && (*lp)->tt == Number) {
-    *wp = ((*lp)->t).number;
-    *lp = (*lp)->next;
+void freeRecogContext(RecogContext *ctx) {
+  freeArena(&ctx->arena);
+  freeInternTable(&ctx->intern);
+  freeEquation(&ctx->eq);
+}
+
+// reads the value of the number and determine whether it is biggest exponent.
+// an exponent must be a natural number that fits in an int
+int valueExponent(List *lp, RecogContext *ctx) {
+  if (*lp != NULL && (*lp)->tt == Number && (*lp)->kind == NumInt) {
     // if the value of the number is bigger than set it as the biggestExponent
-    if (*wp > biggestExponent) {
-      biggestExponent = *wp;
+    if (((*lp)->t).number > ctx->biggestExponent) {
+      ctx->biggestExponent = ((*lp)->t).number;
     }
+    *lp = (*lp)->next;
     return 1;
   }
   return 0;
 }
 
 // accepts exponent '^' character and a natural number succeeding it
-int acceptExponent(List *lp) {
-  double wp = 0;
+int acceptExponent(List *lp, RecogContext *ctx) {
   // checks whether there is an exponent
   if (acceptCharacter(lp, '^')) {
     // only accepts natural numbers
     if (acceptCharacter(lp, '-')) {
       return 0;
     } else {
-      // calls the valueNumber to determine the value of the exponent
-      return valueNumber(lp, &wp);
+      // calls the valueExponent to determine the value of the exponent
+      return valueExponent(lp, ctx);
     }
-  } else {
-    biggestExponent = 1;
-    return 1;
   }
-  return 0;
+  // without an exponent the exponent is 1
+  if (ctx->biggestExponent < 1) {
+    ctx->biggestExponent = 1;
+  }
+  return 1;
 }
 
 // accepts terms in the form of <nat> | [ <nat>] <identifier> ['^' <nat>]
-int acceptTerm(List *lp) {
+int acceptTerm(List *lp, RecogContext *ctx) {
   if (acceptNumber(lp)) {
     if (acceptIdentifier(lp)) {
       // if number and identifier then call acceptExponent to check whether there is an exponent
-      return acceptExponent(lp);
+      return acceptExponent(lp, ctx);
     }
     return 1;
   } else {
     if (acceptIdentifier(lp)) {
       // if there is only identifier then check whether an exponent is inputted
-      return acceptExponent(lp);
+      return acceptExponent(lp, ctx);
     }
     return 0;
   }
@@ -118,22 +150,22 @@ int acceptTerm(List *lp) {
 }
 
 // accepts expressions of the form ['-'] <term> {'+' <term> | '-' <term>}
-int acceptExpression(List *lp) {
+int acceptExpression(List *lp, RecogContext *ctx) {
 
   // checks whether it is a negative number
   if (acceptCharacter(lp, '-')) {
     // checks whether it is a valid term
-    if (!acceptTerm(lp)) {
+    if (!acceptTerm(lp, ctx)) {
       return 0;
     }
   }
-  else if (!acceptTerm(lp)) {
+  else if (!acceptTerm(lp, ctx)) {
     return 0;
   }
 
   while (acceptCharacter(lp, '+') || acceptCharacter(lp, '-')) {
     // checks whether it is a valid term
-    if (!acceptTerm(lp)) {
+    if (!acceptTerm(lp, ctx)) {
       return 0;
     }
   } /* no + or -, so we reached the end of the expression */
@@ -141,71 +173,765 @@ int acceptExpression(List *lp) {
 }
 
 // accepts equations of the the form <expression> '=' <expression>
-int acceptEquation(List *lp) {
-  return (acceptExpression(lp) && acceptCharacter(lp,'=') && acceptExpression(lp));
-}
-
-// determines the amount of variables there are. returns 1 if there is 1 variable
-int determineVariables(List lp) {
-  
-  // initialise string to store the value of the identifiers/variables
-  char *string = NULL;
-  // loop through list 
-  while (lp != NULL) {
-    if (lp->tt == Identifier) {
-      if (string == NULL) {
-        free(string);
-        string = (lp)->t.identifier;
-      } 
-      // conditional to compare whether the variable stored is the same
-      if (strcmp(string, lp->t.identifier)) {
-        return 2;
+// the biggest exponent is reset first, so nothing is left over from a previous equation
+int acceptEquation(List *lp, RecogContext *ctx) {
+  ctx->biggestExponent = -1;
+  return (acceptExpression(lp, ctx) && acceptCharacter(lp,'=') && acceptExpression(lp, ctx));
+}
+
+/* The functions parseTerm, parseExpression and parseEquation recognize the same equations as
+ * acceptTerm, acceptExpression and acceptEquation, and in the same walk over the token list
+ * they add every term to the polynomial of an Equation, with the terms of the right hand side
+ * of '=' negated. Then normalizeEquation takes the variables, the degree and the coefficients
+ * from the normal form, so terms that cancel do not count: x^2 = x^2 + x has degree 1.
+ * So every token is visited exactly once, and the list is not walked again to classify it.
+ */
+
+void initEquation(Equation *eq) {
+  initPoly(&eq->poly);
+  eq->coef = NULL;
+  eq->capacity = 0;
+  eq->ncoef = 0;
+  eq->roots = NULL;
+  eq->nroots = 0;
+  eq->space = NULL;
+  eq->spaceCapacity = 0;
+  eq->exact = 0;
+  eq->hasExactRoot = 0;
+}
+
+void freeEquation(Equation *eq) {
+  freePoly(&eq->poly);
+  free(eq->coef);
+  free(eq->space);
+  initEquation(eq);
+}
+
+// adds c to the coefficient of exponent d; the vector is extended with zeros when needed
+static void addCoefficient(Equation *eq, int d, double c) {
+  if (d > MAXDEGREE) {
+    eq->coefOverflow = 1;
+    return;
+  }
+  if (d >= eq->capacity) {
+    eq->capacity = (eq->capacity == 0 ? 8 : eq->capacity);
+    while (d >= eq->capacity) {
+      eq->capacity = 2 * eq->capacity;
+    }
+    eq->coef = realloc(eq->coef, eq->capacity * sizeof(double));
+    assert(eq->coef != NULL);
+  }
+  while (eq->ncoef <= d) {
+    eq->coef[eq->ncoef] = 0;
+    eq->ncoef++;
+  }
+  eq->coef[d] += c;
+}
+
+// parses a term of the form <nat> | [ <nat>] <identifier> ['^' <nat>]; sign is 1 or -1.
+// in exact mode the coefficient is also added as a fraction, see numberRational
+static int parseTerm(List *lp, Equation *eq, double sign) {
+  List l = *lp;
+  List ident = NULL;
+  Rational q;
+  double c = 1;
+  int d = 0;
+  int number = 0;
+  if (l != NULL && l->tt == Number) {
+    c = numberValue(l);
+    number = 1;
+    l = l->next;
+  }
+  if (l != NULL && l->tt == Identifier) {
+    ident = l;
+    d = 1;
+    l = l->next;
+    if (l != NULL && l->tt == Symbol && (l->t).symbol == '^') {
+      // only accepts natural numbers
+      l = l->next;
+      if (l == NULL || l->tt != Number || l->kind != NumInt) {
+        return 0;
       }
+      d = (l->t).number;
+      l = l->next;
     }
-      if (lp != NULL) {
-        lp = (lp)->next;
+  } else if (!number) {
+    return 0;
+  }
+  // x^0 is 1, so it belongs to the constant term
+  if (eq->exact) {
+    q = (number ? numberRational(*lp) : makeRational(1, 1));
+    addMonomialExact(&eq->poly, d == 0 ? -1 : ident->id, d, sign * c,
+                     sign < 0 ? subRational(makeRational(0, 1), q) : q);
+  } else {
+    addMonomial(&eq->poly, d == 0 ? -1 : ident->id, d, sign * c);
+  }
+  *lp = l;
+  return 1;
+}
+
+// parses an expression of the form ['-'] <term> {'+' <term> | '-' <term>}; side is 1 for
+// the left hand side of '=' and -1 for the right hand side
+static int parseExpression(List *lp, Equation *eq, double side) {
+  double sign = side;
+  if (acceptCharacter(lp, '-')) {
+    sign = -side;
+  }
+  if (!parseTerm(lp, eq, sign)) {
+    return 0;
+  }
+  while (*lp != NULL && (*lp)->tt == Symbol) {
+    if (((*lp)->t).symbol == '+') {
+      sign = side;
+    } else if (((*lp)->t).symbol == '-') {
+      sign = -side;
+    } else {
+      break;
+    }
+    *lp = (*lp)->next;
+    if (!parseTerm(lp, eq, sign)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// tells whether the monomial m has a coefficient other than 0. in exact mode the fraction
+// decides when there is one, since the doubles of 0.1x + 0.2x - 0.3x leave a residue
+static int nonZero(Equation *eq, Monomial *m) {
+  if (eq->exact && m->exact.den != 0) {
+    return m->exact.num != 0;
+  }
+  return m->coef != 0;
+}
+
+// takes the variables and the degree from the monomials with a coefficient other than 0,
+// and fills coef when one variable remains
+static void normalizeEquation(Equation *eq) {
+  Monomial *m;
+  Monomial *end = eq->poly.terms + eq->poly.count;
+  clearVarSet(&eq->vars);
+  eq->degree = 0;
+  eq->ncoef = 0;
+  eq->coefOverflow = 0;
+  for (m = eq->poly.terms; m < end; m++) {
+    if (nonZero(eq, m) && m->var >= 0) {
+      addVariable(&eq->vars, m->var, m->degree);
+      if (m->degree > eq->degree) {
+        eq->degree = m->degree;
       }
+    }
+  }
+  if (eq->vars.count != 1 || eq->vars.overflow) {
+    return;
+  }
+  addCoefficient(eq, 0, 0);
+  for (m = eq->poly.terms; m < end; m++) {
+    if (nonZero(eq, m)) {
+      addCoefficient(eq, m->degree, m->coef);
+    }
   }
-    // if there are no variables
-    if (string == NULL) {
+}
+
+// parses an equation of the form <expression> '=' <expression> into eq. the identifiers
+// must have ids, so the list must come from a scanner with an intern table
+int parseEquation(List *lp, Equation *eq) {
+  clearPoly(&eq->poly);
+  if (parseExpression(lp, eq, 1) && acceptCharacter(lp, '=') && parseExpression(lp, eq, -1)) {
+    normalizeEquation(eq);
+    return 1;
+  }
+  return 0;
+}
+
+/* The functions below are the versions of the accept functions for a token array:
+ * they take a cursor instead of a pointer to a token list, and advance the cursor
+ * where the list versions advance the pointer.
+ */
+
+int acceptNumberC(Cursor *cp) {
+  if (cp->pos < cp->length && cp->tt[cp->pos] == Number) {
+    cp->pos++;
+    return 1;
+  }
+  return 0;
+}
+
+int acceptIdentifierC(Cursor *cp) {
+  if (cp->pos < cp->length && cp->tt[cp->pos] == Identifier) {
+    cp->pos++;
+    return 1;
+  }
+  return 0;
+}
+
+int acceptCharacterC(Cursor *cp, char c) {
+  if (cp->pos < cp->length && cp->tt[cp->pos] == Symbol && cp->value[cp->pos] == c) {
+    cp->pos++;
+    return 1;
+  }
+  return 0;
+}
+
+// accepts exponent '^' character and a natural number succeeding it
+int acceptExponentC(Cursor *cp, RecogContext *ctx) {
+  if (acceptCharacterC(cp, '^')) {
+    // only accepts natural numbers
+    if (cp->pos < cp->length && cp->tt[cp->pos] == Number && cp->ident[cp->pos] < 0) {
+      if (cp->value[cp->pos] > ctx->biggestExponent) {
+        ctx->biggestExponent = cp->value[cp->pos];
+      }
+      cp->pos++;
+      return 1;
+    }
+    return 0;
+  }
+  if (ctx->biggestExponent < 1) {
+    ctx->biggestExponent = 1;
+  }
+  return 1;
+}
+
+// accepts terms in the form of <nat> | [ <nat>] <identifier> ['^' <nat>]
+int acceptTermC(Cursor *cp, RecogContext *ctx) {
+  if (acceptNumberC(cp)) {
+    if (acceptIdentifierC(cp)) {
+      return acceptExponentC(cp, ctx);
+    }
+    return 1;
+  }
+  if (acceptIdentifierC(cp)) {
+    return acceptExponentC(cp, ctx);
+  }
+  return 0;
+}
+
+// accepts expressions of the form ['-'] <term> {'+' <term> | '-' <term>}
+int acceptExpressionC(Cursor *cp, RecogContext *ctx) {
+  acceptCharacterC(cp, '-');
+  if (!acceptTermC(cp, ctx)) {
+    return 0;
+  }
+  while (acceptCharacterC(cp, '+') || acceptCharacterC(cp, '-')) {
+    if (!acceptTermC(cp, ctx)) {
       return 0;
     }
+  }
+  return 1;
+}
 
+// accepts equations of the the form <expression> '=' <expression>
+int acceptEquationC(Cursor *cp, RecogContext *ctx) {
+  ctx->biggestExponent = -1;
+  return (acceptExpressionC(cp, ctx) && acceptCharacterC(cp, '=') && acceptExpressionC(cp, ctx));
+}
+
+// solves an equation in 1 variable of degree 1, a x + b = 0, from the coefficients that
+// parseEquation collected. returns 0 when there is no unique solution (a = 0)
+int solveLinear(Equation *eq, double *xp) {
+  double a = (eq->ncoef > 1 ? eq->coef[1] : 0);
+  double b = (eq->ncoef > 0 ? eq->coef[0] : 0);
+  if (a == 0) {
+    return 0;
+  }
+  *xp = -b / a;
   return 1;
 }
 
+// computes the solution of the linear equation in 1 variable that parseEquation has parsed
+// into eq in exact mode as a fraction, from the exact coefficients of the constant term and of
+// the variable in the normal form. returns 0 when the solution does not fit in a fraction
+int solveLinearExact(Equation *eq, Rational *xp) {
+  Rational c0 = makeRational(0, 1);
+  Rational c1 = makeRational(0, 1);
+  Monomial *m;
+  Monomial *end = eq->poly.terms + eq->poly.count;
+  for (m = eq->poly.terms; m < end; m++) {
+    if (m->var < 0) {
+      c0 = m->exact;
+    } else if (m->var == eq->vars.id[0] && m->degree == 1) {
+      c1 = m->exact;
+    }
+  }
+  if (c1.den == 0 || c1.num == 0) {
+    return 0;
+  }
+  *xp = divRational(subRational(makeRational(0, 1), c0), c1);
+  return xp->den != 0;
+}
+
+// computes the distinct real roots of an equation in 1 variable, in ascending order: degree 1
+// with solveLinear, degree 2 in closed form and higher degrees with Newton's method, see
+// solve.c. returns their number, which is 0 when the coefficients have overflowed
+int solveEquation(Equation *eq) {
+  int n = eq->degree;
+  eq->nroots = 0;
+  if (eq->vars.count != 1 || eq->coefOverflow || n < 1) {
+    return 0;
+  }
+  if (2 * n + 1 > eq->spaceCapacity) {
+    eq->spaceCapacity = 2 * n + 1;
+    free(eq->space);
+    eq->space = malloc(eq->spaceCapacity * sizeof(double));
+    assert(eq->space != NULL);
+  }
+  eq->roots = eq->space;
+  if (n == 1) {
+    eq->nroots = solveLinear(eq, eq->roots);
+  } else {
+    eq->nroots = solvePolynomial(eq->coef, n, eq->space + n, eq->roots);
+  }
+  return eq->nroots;
+}
+
+// yields x, or 0 when x rounds to zero with 3 decimals, so that it is printed as 0.000 and
+// not as -0.000
+static double clampZero(double x) {
+  return (x > -0.0005 && x < 0.0005 ? 0 : x);
+}
+
+// prints a solution with 3 decimals, see clampZero
+void printSolution(FILE *out, double x) {
+  fprintf(out, "solution: %.3f\n", clampZero(x));
+}
+
+/* The function classifyEquation finds out what kind of equation the token list tl is. For an
+ * equation in 1 variable the real solutions are stored in ctx->eq by solveEquation; in exact
+ * mode the solution of a linear equation is also stored as a fraction in eq->exactRoot, and
+ * eq->hasExactRoot is set. The list must have been made by the scanner of the context ctx, so
+ * that its identifiers have ids.
+ */
+EquationKind classifyEquation(List tl, RecogContext *ctx) {
+  Equation *eq = &ctx->eq;
+  List tl1 = tl;
+  EquationKind kind = NoEquation;
+  TIMER_START(TimeRecognize);
+  eq->exact = ctx->exact;
+  eq->hasExactRoot = 0;
+  if (parseEquation(&tl1, eq) && tl1 == NULL) {
+    kind = EquationNVars;
+    if (eq->vars.count == 1 && !eq->vars.overflow) {
+      kind = Equation1Var;
+      solveEquation(eq);
+      if (ctx->exact && eq->degree == 1 && eq->nroots == 1) {
+        eq->hasExactRoot = solveLinearExact(eq, &eq->exactRoot);
+      }
+    }
+  }
+  TIMER_STOP(TimeRecognize);
+  return kind;
+}
+
+/* The function recognizeList prints on out what kind of equation the token list tl is, and
+ * the real solutions of an equation in 1 variable, one per line in ascending order; in exact
+ * mode the solution of a linear equation is a fraction. For a degree above MAXDEGREE, whose
+ * solutions are not computed, it prints that the degree is too high. The list must have been made by the
+ * scanner of the context ctx, so that its identifiers have ids.
+ * It is shared by the dialogue recognizeEquations and the batch modes.
+ */
+void recognizeList(FILE *out, List tl, RecogContext *ctx) {
+  Equation *eq = &ctx->eq;
+  int i;
+  switch (classifyEquation(tl, ctx)) {
+  case Equation1Var:
+    fprintf(out, "this is an equation in 1 variable of degree %d\n", eq->degree);
+    if (eq->hasExactRoot) {
+      fprintf(out, "solution: ");
+      fprintRational(out, eq->exactRoot);
+      fprintf(out, "\n");
+    } else if (eq->degree > MAXDEGREE) {
+      fprintf(out, "degree too high\n");
+    } else {
+      for (i = 0; i < eq->nroots; i++) {
+        printSolution(out, eq->roots[i]);
+      }
+    }
+    break;
+  case EquationNVars:
+    fprintf(out, "this is an equation, but not in 1 variable\n");
+    break;
+  case NoEquation:
+    fprintf(out, "this is not an equation\n");
+    break;
+  }
+}
+
+static void answerEquation(FILE *out, List tl, void *ctx) {
+  recognizeList(out, tl, ctx);
+}
+
+/* The function recognizeTokens prints on out the token list tl and what kind of equation it
+ * is, as the dialogue does; with a cache the answer may come from there instead. The list must
+ * be in the arena of ctx, which is reset afterwards; the intern table of ctx is cleared too, so
+ * that it does not grow with the number of lines, and the ids of a line stay small.
+ */
+void recognizeTokens(FILE *out, RecogContext *ctx, List tl) {
+  fprintList(out, tl);
+  if (ctx->cache != NULL) {
+    answerCached(ctx->cache, out, tl, answerEquation, ctx);
+  } else {
+    recognizeList(out, tl, ctx);
+  }
+  resetArena(&ctx->arena);
+  clearInternTable(&ctx->intern);
+}
+
+/* The function recognizeLine scans the line of the given length at ar with the scanner of
+ * ctx, and then does what recognizeTokens does.
+ */
+void recognizeLine(FILE *out, RecogContext *ctx, char *ar, int length) {
+  recognizeTokens(out, ctx, scanLine(&ctx->scanner, ar, length));
+}
 
 /* The function recognizeExpressions demonstrates the recognizer. */
 void recognizeEquations() {
   char *ar;
-  List tl, tl1;
+  List tl;
+  RecogContext ctx;
+  initRecogContext(&ctx);
   printf("give an equation: ");
   ar = readInput();
   while (ar[0] != '!') {
-    tl = tokenList(ar);
+    tl = scanLine(&ctx.scanner, ar, strlen(ar));
     printList(tl);
-    tl1 = tl;
-    if (acceptEquation(&tl1) && tl1 == NULL) {
-      // conditional if there is one variable
-      if (determineVariables(tl) == 1) {
-          printf("this is an equation in 1 variable");
-          printf("%s %s %d\n", " of", "degree", biggestExponent);
-        // resets the biggestExponent
-        biggestExponent = -1;
+    recognizeList(stdout, tl, &ctx);
+    releaseLine(ar, tl, &ctx.arena);
+    clearInternTable(&ctx.intern);
+    printf("\ngive an equation: ");
+    ar = readInput();
+  }
+  free(ar);
+  freeRecogContext(&ctx);
+  printf("good bye\n");
+  INSTRUMENT_DUMP(stderr);
+}
+
+// writes a solution with 3 decimals, see clampZero
+static void writeSolution(Writer *w, double x) {
+  writeFixed(w, clampZero(x), 3);
+}
+
+static void writeRational(Writer *w, Rational x) {
+  writeInt(w, x.num);
+  if (x.den != 1) {
+    writeChar(w, '/');
+    writeInt(w, x.den);
+  }
+}
+
+/* The function writeAnswer writes with w the same answer to the token list tl as recognizeList
+ * prints.
+ */
+static void writeAnswer(Writer *w, List tl, RecogContext *ctx) {
+  Equation *eq = &ctx->eq;
+  int i;
+  switch (classifyEquation(tl, ctx)) {
+  case Equation1Var:
+    writeString(w, "this is an equation in 1 variable of degree ");
+    writeInt(w, eq->degree);
+    writeChar(w, '\n');
+    if (eq->hasExactRoot) {
+      writeString(w, "solution: ");
+      writeRational(w, eq->exactRoot);
+      writeChar(w, '\n');
+    } else if (eq->degree > MAXDEGREE) {
+      writeString(w, "degree too high\n");
+    } else {
+      for (i = 0; i < eq->nroots; i++) {
+        writeString(w, "solution: ");
+        writeSolution(w, eq->roots[i]);
+        writeChar(w, '\n');
       }
-      // conditional if there are more than 1 variable
-      else if (determineVariables(tl) != 1) {
-        printf("this is an equation, but not in 1 variable\n");
+    }
+    break;
+  case EquationNVars:
+    writeString(w, "this is an equation, but not in 1 variable\n");
+    break;
+  case NoEquation:
+    writeString(w, "this is not an equation\n");
+    break;
+  }
+}
+
+/* The function writeAnswerCached writes the answer to tl from the cache of ctx, when it is
+ * there. Otherwise the answer is written by writeAnswer and then stored in the cache, straight
+ * from the buffer of w, unless the buffer has been flushed in between.
+ */
+static void writeAnswerCached(Writer *w, List tl, RecogContext *ctx) {
+  const char *value;
+  int length;
+  size_t start = w->length;
+  long flushes = w->flushes;
+  value = lookupCache(ctx->cache, tl, &length);
+  if (value != NULL) {
+    writeBytes(w, value, length);
+    return;
+  }
+  writeAnswer(w, tl, ctx);
+  if (w->flushes == flushes) {
+    insertCache(ctx->cache, w->buf + start, (int)(w->length - start));
+  }
+}
+
+static const char *kindNames[] = {"not_equation", "equation", "equation_1var"};
+
+/* The function writeRecord writes the record of line number of the token list tl in a machine
+ * readable format: for FormatTsv the line number, the kind, the degree and the solutions
+ * separated by commas, separated by tabs, e.g.
+ *   3	equation_1var	2	-1.000,1.000
+ * and for FormatJson an object on one line, e.g.
+ *   {"line":3,"class":"equation_1var","degree":2,"solutions":[-1.000,1.000]}
+ * The degree is left out when tl is not an equation, and the solutions when it is not one in
+ * 1 variable. A fraction of exact mode is a string in JSON, e.g. "-1/3". For a degree above
+ * MAXDEGREE the solutions are not computed, and degree_too_high stands in their place, as a
+ * string in JSON.
+ */
+static void writeRecord(Writer *w, long number, List tl, RecogContext *ctx,
+                        OutputFormat format) {
+  Equation *eq = &ctx->eq;
+  EquationKind kind = classifyEquation(tl, ctx);
+  int json = (format == FormatJson);
+  int i;
+  writeString(w, (json ? "{\"line\":" : ""));
+  writeInt(w, number);
+  writeString(w, (json ? ",\"class\":\"" : "\t"));
+  writeString(w, kindNames[kind]);
+  writeString(w, (json ? "\"" : "\t"));
+  if (kind != NoEquation) {
+    writeString(w, (json ? ",\"degree\":" : ""));
+    writeInt(w, eq->degree);
+  }
+  if (kind == Equation1Var) {
+    writeString(w, (json ? ",\"solutions\":[" : "\t"));
+    if (eq->hasExactRoot) {
+      writeString(w, (json ? "\"" : ""));
+      writeRational(w, eq->exactRoot);
+      writeString(w, (json ? "\"" : ""));
+    } else if (eq->degree > MAXDEGREE) {
+      writeString(w, (json ? "\"degree_too_high\"" : "degree_too_high"));
+    } else {
+      for (i = 0; i < eq->nroots; i++) {
+        if (i > 0) {
+          writeChar(w, ',');
+        }
+        writeSolution(w, eq->roots[i]);
       }
     }
-    else {
-      printf("this is not an equation\n");
+    writeString(w, (json ? "]" : ""));
+  } else if (!json) {
+    writeChar(w, '\t');
+  }
+  writeString(w, (json ? "}\n" : "\n"));
+}
+
+/* The function writeLine writes with w what recognizeTokens prints for the token list tl of
+ * line number, preceded by the prompt for it, or its record when format is not FormatText.
+ */
+static void writeLine(Writer *w, long number, List tl, RecogContext *ctx,
+                      OutputFormat format) {
+  if (format != FormatText) {
+    writeRecord(w, number, tl, ctx, format);
+  } else {
+    writeString(w, "give an equation: ");
+    writeTokens(w, tl);
+    if (ctx->cache != NULL) {
+      writeAnswerCached(w, tl, ctx);
+    } else {
+      writeAnswer(w, tl, ctx);
     }
-    free(ar);
-    freeTokenList(tl);
-    printf("\ngive an equation: ");
-    ar = readInput();
+    writeChar(w, '\n');
   }
-  free(ar);
+  resetArena(&ctx->arena);
+  clearInternTable(&ctx->intern);
+}
+
+/* The function recognizeBatch recognizes the lines of the input in, which has been
+ * opened with openInput, and prints exactly what recognizeEquations prints for the same input,
+ * or one record per line when format is FormatTsv or FormatJson, see writeRecord; the lines
+ * are numbered from 1. The output goes to standard output through a Writer, so it takes a
+ * write per WRITERBLOCK bytes and no printf at all.
+ * The lines are scanned in place, so no memory is allocated per line.
+ * It stops at a line that starts with '!', or at the end of the input. The answers are looked
+ * up in cache, unless it is NULL; there is no cache for the records. When exact is set, the
+ * context is in exact mode. It yields 0 when the output could not be written, and 1 otherwise.
+ */
+int recognizeBatch(Input *in, Cache *cache, int exact, OutputFormat format) {
+  Line line;
+  RecogContext ctx;
+  Writer w;
+  long number = 0;
+  int ok;
+  initRecogContext(&ctx);
+  ctx.cache = (format == FormatText ? cache : NULL);
+  ctx.exact = exact;
+  fflush(stdout);
+  initWriter(&w, STDOUT_FILENO);
+  while (nextLine(in, &line) && (line.length == 0 || line.start[0] != '!')) {
+    number++;
+    writeLine(&w, number, scanLine(&ctx.scanner, line.start, line.length), &ctx, format);
+  }
+  if (format == FormatText) {
+    writeString(&w, "give an equation: good bye\n");
+  }
+  ok = freeWriter(&w);
+  freeRecogContext(&ctx);
+  INSTRUMENT_DUMP(stderr);
+  return ok;
+}
+
+/* The function recognizeTokenFile recognizes the lines of the token file tf, see tokenFile.h,
+ * and prints the same as recognizeBatch for the input from which tf was written. The token
+ * lists are made from the records, so the lines are not scanned; the ids of the identifiers
+ * are those of the identifier table of tf. A token file keeps only the double of a decimal
+ * number, so in exact mode a solution may differ from that of recognizeBatch, see
+ * numberRational. It yields 0 when the output could not be written, and 1 otherwise.
+ */
+int recognizeTokenFile(const TokenFile *tf, Cache *cache, int exact, OutputFormat format) {
+  RecogContext ctx;
+  Writer w;
+  size_t i;
+  int ok;
+  initRecogContext(&ctx);
+  ctx.cache = (format == FormatText ? cache : NULL);
+  ctx.exact = exact;
+  fflush(stdout);
+  initWriter(&w, STDOUT_FILENO);
+  for (i = 0; i < tf->nlines; i++) {
+    writeLine(&w, (long)i + 1, tokenFileLine(tf, i, &ctx.arena), &ctx, format);
+  }
+  if (format == FormatText) {
+    writeString(&w, "give an equation: good bye\n");
+  }
+  ok = freeWriter(&w);
+  freeRecogContext(&ctx);
+  INSTRUMENT_DUMP(stderr);
+  return ok;
+}
+
+// prints the value of the variable name with 3 decimals, see clampZero
+static void printVariable(FILE *out, const char *name, double x) {
+  fprintf(out, "%s = %.3f\n", name, clampZero(x));
+}
+
+/* The function answerSystem prints what kind of system the block in s is, after its lines;
+ * linear is 0 when one of them was not a linear equation.
+ */
+static void answerSystem(FILE *out, LinearSystem *s, int linear, RecogContext *ctx) {
+  int c;
+  if (!linear) {
+    fprintf(out, "this is not a linear system\n");
+    return;
+  }
+  fprintf(out, "this is a linear system of %d equation%s in %d variable%s", s->rows,
+          (s->rows == 1 ? "" : "s"), s->cols, (s->cols == 1 ? "" : "s"));
+  if (!solveLinearSystem(s)) {
+    fprintf(out, " without a unique solution\n");
+    return;
+  }
+  fprintf(out, "\n");
+  for (c = 0; c < s->cols; c++) {
+    printVariable(out, identifierName(&ctx->intern, s->vars[c]), s->x[c]);
+  }
+}
+
+/* The function recognizeSystems reads the lines of the input in as blocks of equations that
+ * are separated by empty lines, up to a line that starts with '!', and solves every block as a
+ * system of linear equations in several variables, see linsys.h. It prints the token lists of
+ * the lines of a block, and then the solution, one variable per line in the order in which the
+ * variables first occur. The variables are the identifier ids of the intern table of the
+ * context, so a variable has the same column wherever it occurs in the block.
+ */
+void recognizeSystems(Input *in) {
+  Line line;
+  RecogContext ctx;
+  LinearSystem s;
+  List tl;
+  int linear = 1, more = 1;
+  initRecogContext(&ctx);
+  initLinearSystem(&s);
+  while (more) {
+    more = nextLine(in, &line) && (line.length == 0 || line.start[0] != '!');
+    if (more && line.length > 0) {
+      if (s.rows == 0 && linear) {
+        printf("give a system: ");
+      }
+      tl = scanLine(&ctx.scanner, line.start, line.length);
+      fprintList(stdout, tl);
+      if (linear) {
+        linear = parseEquation(&tl, &ctx.eq) && tl == NULL && addEquationRow(&s, &ctx.eq.poly);
+      }
+      resetArena(&ctx.arena);
+    } else if (s.rows > 0 || !linear) { /* the end of a block */
+      answerSystem(stdout, &s, linear, &ctx);
+      printf("\n");
+      clearLinearSystem(&s);
+      clearInternTable(&ctx.intern);
+      linear = 1;
+    }
+  }
+  freeLinearSystem(&s);
+  freeRecogContext(&ctx);
   printf("good bye\n");
-}
\ No newline at end of file
+  INSTRUMENT_DUMP(stderr);
+}
+
+/* The function recognizeStream recognizes the lines that are read from the file descriptor fd,
+ * e.g. a pipe or a socket, and prints the same as recognizeBatch. The input is read with read
+ * in blocks of at most STREAMBLOCK bytes, as it arrives, and fed to a StreamScanner, so a line
+ * is never buffered as a whole: its tokens are collected in the arena of the context until
+ * the end of the line, where the list is recognized.
+ */
+void recognizeStream(int fd) {
+  char block[STREAMBLOCK];
+  RecogContext ctx;
+  StreamScanner ss;
+  struct ListNode head;
+  List last = &head;
+  List t;
+  ssize_t n;
+  int done = 0;
+  initRecogContext(&ctx);
+  ctx.scanner.views = 0; // the tokens must not point into block
+  initStreamScanner(&ss, &ctx.scanner);
+  head.next = NULL;
+  printf("give an equation: ");
+  while (!done) {
+    switch (nextToken(&ss, &t)) {
+    case StreamNeedInput:
+      do {
+        n = read(fd, block, sizeof(block));
+      } while (n < 0 && errno == EINTR);
+      if (n > 0) {
+        feedStream(&ss, block, n);
+      } else {
+        endStream(&ss);
+      }
+      break;
+    case StreamToken:
+      // a line that starts with '!' ends the input
+      if (head.next == NULL && ss.column == 0 && t->tt == Symbol && (t->t).symbol == '!') {
+        done = 1;
+      } else {
+        last->next = t;
+        last = t;
+      }
+      break;
+    case StreamEndOfLine:
+      fprintList(stdout, head.next);
+      recognizeList(stdout, head.next, &ctx);
+      resetArena(&ctx.arena);
+      clearInternTable(&ctx.intern);
+      head.next = NULL;
+      last = &head;
+      printf("\ngive an equation: ");
+      break;
+    case StreamEnd:
+      done = 1;
+      break;
+    }
+  }
+  freeStreamScanner(&ss);
+  freeRecogContext(&ctx);
+  printf("good bye\n");
+  INSTRUMENT_DUMP(stderr);
+}
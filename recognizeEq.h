@@ -3,15 +3,116 @@
 #ifndef RECOGNIZEEXP_H
 #define RECOGNIZEEXP_H
 
+#include "tokenArray.h"
+#include "input.h"
+#include "poly.h"
+#include "solve.h"
+#include "linsys.h"
+#include "cache.h"
+#include "tokenFile.h"
+#include "rational.h"
+#include "writer.h"
+
+#define STREAMBLOCK 4096 /* size of the blocks that recognizeStream reads */
+
+/* An Equation is what parseEquation finds out about an equation in one walk:
+ * poly is its normal form, with all terms brought to the left hand side of '=' and like terms
+ * combined. vars is the set of variables and degree the highest exponent that remain in the
+ * normal form, i.e. that have a coefficient other than 0. When there is one variable x,
+ * coef[d], for 0 <= d < ncoef, is the coefficient of x^d, so the equation is
+ * coef[0] + coef[1] x + ... = 0. Exponents above MAXDEGREE are not kept in coef; then
+ * coefOverflow is set, and an equation of a degree above MAXDEGREE is not solved, but its
+ * answer says that the degree is too high. solveEquation stores the real roots in roots[0..nroots-1]; roots and
+ * the memory that the solver needs are kept in space, which is reused for every equation.
+ * When exact is set, parseEquation also adds up the coefficients of poly as fractions, and
+ * classifyEquation then stores the solution of a linear equation as a fraction in exactRoot,
+ * and sets hasExactRoot.
+ */
+
+#define MAXDEGREE 4096
+
+typedef struct Equation {
+  Poly poly;
+  VarSet vars;
+  int degree;
+  double *coef;
+  int ncoef;
+  int capacity;
+  int coefOverflow;
+  double *roots;
+  int nroots;
+  double *space;
+  int spaceCapacity;
+  int exact;
+  Rational exactRoot;
+  int hasExactRoot;
+} Equation;
+
+/* The kinds of token lists that classifyEquation tells apart. */
+
+typedef enum EquationKind {
+  NoEquation,
+  EquationNVars,
+  Equation1Var
+} EquationKind;
+
+/* A RecogContext holds all state of one recognizer: the biggest exponent seen by
+ * acceptExponent, and the scanner with its arena and intern table, and the Equation that
+ * recognizeList uses for every line. There is no global state, so recognizers with different
+ * contexts can run concurrently, e.g. on several threads. When cache is not NULL,
+ * recognizeLine looks the answers up in it, see cache.h. When exact is set, the solution of a
+ * linear equation is printed as a fraction, see solveLinearExact.
+ */
+
+typedef struct RecogContext {
+  int biggestExponent;
+  Arena arena;
+  InternTable intern;
+  Scanner scanner;
+  Equation eq;
+  Cache *cache;
+  int exact;
+} RecogContext;
+
+void initRecogContext(RecogContext *ctx);
+void freeRecogContext(RecogContext *ctx);
+
 int acceptNumber(List *lp);
 int acceptIdentifier(List *lp);
 int acceptCharacter(List *lp, char c);
-int acceptExpression(List *lp);
+int acceptExpression(List *lp, RecogContext *ctx);
 void recognizeEquations();
+EquationKind classifyEquation(List tl, RecogContext *ctx);
+void recognizeList(FILE *out, List tl, RecogContext *ctx);
+void recognizeTokens(FILE *out, RecogContext *ctx, List tl);
+void recognizeLine(FILE *out, RecogContext *ctx, char *ar, int length);
+int recognizeBatch(Input *in, Cache *cache, int exact, OutputFormat format);
+void recognizeStream(int fd);
+void recognizeSystems(Input *in);
+int recognizeTokenFile(const TokenFile *tf, Cache *cache, int exact, OutputFormat format);
 
 // added functions
-int acceptExponent(List *lp);
-int acceptEquation(List *lp);
+int valueExponent(List *lp, RecogContext *ctx);
+int acceptExponent(List *lp, RecogContext *ctx);
+int acceptTerm(List *lp, RecogContext *ctx);
+int acceptEquation(List *lp, RecogContext *ctx);
+
+void initEquation(Equation *eq);
+void freeEquation(Equation *eq);
+int parseEquation(List *lp, Equation *eq);
+int solveLinear(Equation *eq, double *xp);
+int solveLinearExact(Equation *eq, Rational *xp);
+int solveEquation(Equation *eq);
+void printSolution(FILE *out, double x);
+
+// versions for a token array, see tokenArray.h
+int acceptNumberC(Cursor *cp);
+int acceptIdentifierC(Cursor *cp);
+int acceptCharacterC(Cursor *cp, char c);
+int acceptExponentC(Cursor *cp, RecogContext *ctx);
+int acceptTermC(Cursor *cp, RecogContext *ctx);
+int acceptExpressionC(Cursor *cp, RecogContext *ctx);
+int acceptEquationC(Cursor *cp, RecogContext *ctx);
 
 
 #endif
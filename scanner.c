@@ -6,12 +6,15 @@
  * A token is: a number, an identifier or a symbol.
  */
 
-#include <stdio.h>  /* getchar, printf */
-#include <stdlib.h> /* NULL, malloc, free */
-#include <string.h> /* strcpy */
+#include <stdio.h>  /* getchar, printf, fprintf, sprintf */
+#include <stdlib.h> /* NULL, malloc, free, strtod */
+#include <limits.h> /* INT_MAX, LLONG_MAX */
+#include <string.h> /* strlen, memcpy */
 #include <ctype.h>  /* isspace, isdigit, isalpha, isalnum */
 #include <assert.h> /* assert */
 #include "scanner.h"
+#include "simd.h"
+#include "instrument.h"
 
 /* The function readInput reads the input and yields a string containing this input.
  * Initially, the length of s is MAXINPUT: it is doubled when necessary.
@@ -21,7 +24,9 @@ char *readInput() {
   int strLen = MAXINPUT;
   int c = getchar();
   int i = 0;
-  char *s = malloc((strLen + 1) * sizeof(char));
+  char *s;
+  TIMER_START(TimeRead);
+  s = malloc((strLen + 1) * sizeof(char));
   assert(s != NULL);
   while (c != '\n') {
     s[i] = c;
@@ -30,25 +35,129 @@ char *readInput() {
       strLen = 2 * strLen;
       s = realloc(s, (strLen + 1) * sizeof(char));
       assert(s != NULL);
+      COUNT(CountReallocBytes, strLen + 1);
     }
     c = getchar();
   }
   s[i] = '\0';
+  TIMER_STOP(TimeRead);
   return s;
 }
 
 /* The functions matchNumber, matchCharacter and matchIdentifier do what their name indicates
- * and yield what has been read. Their parameters are the array from which to read and a pointer
- * to an index in the array. The value of the index is adapted during reading.
+ * and yield what has been read. Their parameters are the array from which to read, a pointer
+ * to an index in the array and the length of the array. The value of the index is adapted
+ * during reading. The array need not be terminated by '\0': nothing beyond the length is read.
+ * matchNumber reads a number of the form <digits> [ '.' <digits> ], stores it in *tp and yields
+ * its kind, see scanner.h. It reads the first three digits one at a time, since most numbers
+ * are short and fit in an int; the rest of a longer number, or a number with a fraction,
+ * is read by matchLongNumber.
  */
 
-int matchNumber(char *ar, int *ip) {
+static const double powersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* The function decimalValue yields the value of the number ar[start..end-1], which consists of
+ * digits and at most one '.'. When it has at most 15 digits after the leading zeros, they form
+ * an integer below 2^53 and the number is that integer divided by a power of ten, both exact
+ * doubles, so one division gives the correctly rounded value. Otherwise strtod does the work,
+ * on a copy that is terminated by '\0'.
+ */
+
+static double decimalValue(char *ar, int start, int point, int end, int length) {
+  unsigned long long m;
+  int first = start;
+  int fraction = (point < end ? end - point - 1 : 0);
+  char buffer[64];
+  char *s;
+  double w;
+  while (first < point - 1 && ar[first] == '0') {
+    first++;
+  }
+  if (point - first + fraction <= 15) {
+    m = digitsValue(ar + first, point - first, length - first);
+    if (fraction > 0) {
+      m = m * (unsigned long long)powersOfTen[fraction] +
+          digitsValue(ar + point + 1, fraction, length - point - 1);
+    }
+    return (double)m / powersOfTen[fraction];
+  }
+  s = (end - start < (int)sizeof(buffer) ? buffer : malloc(end - start + 1));
+  assert(s != NULL);
+  memcpy(s, ar + start, end - start);
+  s[end - start] = '\0';
+  w = strtod(s, NULL);
+  if (s != buffer) {
+    free(s);
+  }
+  return w;
+}
+
+/* The function matchLongNumber reads the number that starts at ar[start]; the digits before
+ * *ip have been read already. The integer part is found with skipDigits and converted with
+ * digitsValue, many digits at a time, see simd.h. An integer of at most 19 digits after the
+ * leading zeros is exact in an unsigned long long, so overflow is detected by comparing with
+ * LLONG_MAX; a longer one does not fit.
+ */
+
+static NumberKind matchLongNumber(char *ar, int start, int *ip, int length, Token *tp) {
+  int point = skipDigits(ar, *ip, length);
+  int first = start;
+  unsigned long long v;
+  if (point + 1 < length && ar[point] == '.' && isdigit(ar[point + 1])) {
+    *ip = skipDigits(ar, point + 1, length);
+    tp->decimal = decimalValue(ar, start, point, *ip, length);
+    return NumDecimal;
+  }
+  *ip = point;
+  while (first < point - 1 && ar[first] == '0') {
+    first++;
+  }
+  if (point - first <= 19) {
+    v = digitsValue(ar + first, point - first, length - first);
+    if (v <= INT_MAX) {
+      tp->number = (int)v;
+      return NumInt;
+    }
+    if (v <= LLONG_MAX) {
+      tp->wide = (long long)v;
+      return NumLong;
+    }
+  }
+  tp->decimal = decimalValue(ar, start, point, point, length);
+  return NumDecimal;
+}
+
+NumberKind matchNumber(char *ar, int *ip, int length, Token *tp) {
+  int start = *ip;
   int n = 0;
-  while (isdigit(ar[*ip])) {
+  while (*ip < length && isdigit(ar[*ip])) {
+    if (*ip - start == 3) {
+      return matchLongNumber(ar, start, ip, length, tp);
+    }
     n = 10 * n + (ar[*ip] - '0');
     (*ip)++;
   }
-  return n;
+  if (*ip + 1 < length && ar[*ip] == '.' && isdigit(ar[*ip + 1])) {
+    return matchLongNumber(ar, start, ip, length, tp);
+  }
+  tp->number = n;
+  return NumInt;
+}
+
+/* The function numberValue yields the value of a number token of any kind. */
+
+double numberValue(List l) {
+  switch (l->kind) {
+  case NumInt:
+    return (l->t).number;
+  case NumLong:
+    return (double)(l->t).wide;
+  default:
+    return (l->t).decimal;
+  }
 }
 
 char matchCharacter(char *ar, int *ip) {
@@ -58,43 +167,111 @@ char matchCharacter(char *ar, int *ip) {
 }
 
 /* In matchIdentifier the length of the string is adapted whenver necessary, as in readInput.
+ * When a scanner with an arena is given, the length of the identifier is determined first and
+ * the string is allocated in the arena at once; with views the string is not copied at all.
+ * The length of the identifier is stored in *lp.
  */
 
-char *matchIdentifier(char *ar, int *ip) {
+char *matchIdentifier(char *ar, int *ip, int length, Scanner *sc, int *lp) {
   int j = 0;
   int strLen = MAXIDENT;
-  char *s = malloc((strLen + 1) * sizeof(char));
+  char *s;
+  if (sc->arena != NULL) {
+    while (*ip + j < length && isalnum(ar[*ip + j])) {
+      j++;
+    }
+    *lp = j;
+    if (sc->views) {
+      s = ar + *ip;
+      *ip = *ip + j;
+      return s;
+    }
+    s = arenaAlloc(sc->arena, (j + 1) * sizeof(char));
+    COUNT(CountIdentifiers, 1);
+    memcpy(s, ar + *ip, j);
+    s[j] = '\0';
+    *ip = *ip + j;
+    return s;
+  }
+  s = malloc((strLen + 1) * sizeof(char));
   assert(s != NULL);
-  while (isalnum(ar[*ip + j])) {
+  COUNT(CountIdentifiers, 1);
+  while (*ip + j < length && isalnum(ar[*ip + j])) {
     s[j] = ar[*ip + j];
     j++;
     if (j >= strLen) { /* s is not large enough, its length is doubled */
       strLen = 2 * strLen;
       s = realloc(s, (strLen + 1) * sizeof(char));
       assert(s != NULL);
+      COUNT(CountReallocBytes, strLen + 1);
     }
   }
   s[j] = '\0';
   *ip = *ip + j;
+  *lp = j;
   return s;
 }
 
 /* The function newNode makes a new node for the token list and fills it with the token that
- * has been read.
+ * has been read. The node is allocated by allocNode in the arena of the scanner, or with malloc,
+ * with extra bytes behind it.
  */
 
-List newNode(char *ar, int *ip) { /* precondition: !isspace(a[*ip]) */
-  List node = malloc(sizeof(struct ListNode));
-  assert(node != NULL);
+static List allocNode(Scanner *sc, int extra) {
+  List node;
+  if (sc->arena != NULL) {
+    node = arenaAlloc(sc->arena, sizeof(struct ListNode) + extra);
+  } else {
+    node = malloc(sizeof(struct ListNode) + extra);
+    assert(node != NULL);
+  }
+  COUNT(CountNodes, 1);
   node->next = NULL;
+  node->kind = NumInt;
+  node->length = 0;
+  node->id = -1;
+  return node;
+}
+
+/* The function numberNode makes the node of the number that starts at ar[*ip]. A NumDecimal
+ * node keeps the characters of the number behind it, see numberLiteral.
+ */
+
+static List numberNode(char *ar, int *ip, int length, Scanner *sc) {
+  int start = *ip;
+  Token t;
+  NumberKind kind = matchNumber(ar, ip, length, &t);
+  int n = (kind == NumDecimal ? *ip - start : 0);
+  List node = allocNode(sc, n);
+  node->tt = Number;
+  node->kind = kind;
+  node->t = t;
+  node->length = n;
+  memcpy((char *)(node + 1), ar + start, n);
+  return node;
+}
+
+/* The function numberLiteral yields the characters of a NumDecimal number as they were
+ * written, of which there are l->length, not terminated by '\0'; or NULL when the node was not
+ * made by the scanner, e.g. for a token file, so that only the double is known.
+ */
+
+const char *numberLiteral(List l) {
+  return (l->length > 0 ? (const char *)(l + 1) : NULL);
+}
+
+List newNode(char *ar, int *ip, int length, Scanner *sc) { /* precondition: !isspace(a[*ip]) */
+  List node;
   if (isdigit(ar[*ip])) { /* we see a digit, so a number starts here */
-    node->tt = Number;
-    (node->t).number = matchNumber(ar, ip);
-    return node;
+    return numberNode(ar, ip, length, sc);
   }
+  node = allocNode(sc, 0);
   if (isalpha(ar[*ip])) { /* we see a letter, so an identifier starts here */
     node->tt = Identifier;
-    (node->t).identifier = matchIdentifier(ar, ip);
+    (node->t).identifier = matchIdentifier(ar, ip, length, sc, &node->length);
+    if (sc->intern != NULL) {
+      node->id = internIdentifier(sc->intern, (node->t).identifier, node->length);
+    }
     return node;
   } /* no space, no number, no identifier: we call it a symbol */
   node->tt = Symbol;
@@ -102,21 +279,40 @@ List newNode(char *ar, int *ip) { /* precondition: !isspace(a[*ip]) */
   return node;
 }
 
-/* The function tokenList reads an array and puts the tokens that are read in a list.
+void initScanner(Scanner *sc, Arena *a) {
+  sc->arena = a;
+  sc->views = 0;
+  sc->intern = NULL;
+}
+
+/* The function scanLine reads the first length characters of an array and puts the
+ * tokens that are read in a list, in the way described by the scanner sc.
  * The result is a pointer to the beginning of the list.
+ * When the scanner has an arena, all nodes and identifier strings are allocated in it; such
+ * a list is released with resetArena, not with freeTokenList.
+ * The function tokenListSlice scans with an arena a, or with malloc when a is NULL.
+ * The functions tokenListArena and tokenList read a string up to its terminating '\0',
+ * tokenList without an arena.
  */
 
-List tokenList(char *ar) {
+#ifndef SCANNER_TABLE
+
+List scanLine(Scanner *sc, char *ar, int length) {
+  assert(sc->arena != NULL || !sc->views);
   List lastNode = NULL;
   List node = NULL;
   List tl = NULL;
   int i = 0;
-  int length = strlen(ar);
+  TIMER_START(TimeScan);
   while (i < length) {
-    if (isspace(ar[i])) { /* spaces are skipped */
+    if (isspace(ar[i])) { /* spaces are skipped; a run of them many at a time */
       i++;
+      if (i < length && isspace(ar[i])) {
+        i = skipSpaces(ar, i, length);
+      }
     } else {
-      node = newNode(ar, &i);
+      node = newNode(ar, &i, length, sc);
+      COUNT(CountTokens, 1);
       if (lastNode == NULL) { /* there is no list yet */
         tl = node;
       } else { /* there is already a list; add node at the end */
@@ -125,43 +321,230 @@ List tokenList(char *ar) {
       lastNode = node;
     }
   }
+  TIMER_STOP(TimeScan);
   return tl;
 }
 
-/* The function printList prints the tokens in a token list, separated by spaces.
+#else
+
+/* With SCANNER_TABLE defined, scanLine is a DFA instead: every character is classified with
+ * one lookup in the table charClass, which does not depend on the locale as the functions of
+ * ctype.h do, and the class and the state give the next state. A number or an identifier ends
+ * where the state changes; a symbol is a token of its own. A '.' between digits in a number
+ * is the decimal point, the one exception to the table. The tokens are the same as those
+ * of newNode. The table is for the "C" locale, so characters above 127 are symbols.
  */
 
-void printList(List li) {
+enum CharClass { ClassSpace, ClassDigit, ClassAlpha, ClassOther };
+enum ScanState { StateStart, StateNumber, StateIdentifier };
+
+#define S ClassSpace
+#define D ClassDigit
+#define A ClassAlpha
+#define O ClassOther
+
+static const unsigned char charClass[256] = {
+  O, O, O, O, O, O, O, O, O, S, S, S, S, S, O, O, /* \t \n \v \f \r */
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+  S, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* space and punctuation */
+  D, D, D, D, D, D, D, D, D, D, O, O, O, O, O, O, /* 0-9 */
+  O, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, /* A-O */
+  A, A, A, A, A, A, A, A, A, A, A, O, O, O, O, O, /* P-Z */
+  O, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, /* a-o */
+  A, A, A, A, A, A, A, A, A, A, A, O, O, O, O, O, /* p-z */
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 128-255 */
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+  O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O
+};
+
+#undef S
+#undef D
+#undef A
+#undef O
+
+static const unsigned char transition[3][4] = {
+  /*                  space       digit        alpha            other */
+  /* start */      {StateStart, StateNumber, StateIdentifier, StateStart},
+  /* number */     {StateStart, StateNumber, StateIdentifier, StateStart},
+  /* identifier */ {StateStart, StateIdentifier, StateIdentifier, StateStart}
+};
+
+/* The function tokenNode makes the node of the number or identifier ar[start..end-1]; the
+ * value of a number is computed by matchNumber.
+ */
+
+static List tokenNode(Scanner *sc, char *ar, int start, int end, int state) {
+  List node;
+  char *s;
+  if (state == StateNumber) {
+    return numberNode(ar, &start, end, sc);
+  }
+  node = allocNode(sc, 0);
+  node->tt = Identifier;
+  node->length = end - start;
+  if (sc->views) {
+    s = ar + start;
+  } else {
+    s = (sc->arena != NULL ? arenaAlloc(sc->arena, end - start + 1) : malloc(end - start + 1));
+    assert(s != NULL);
+    COUNT(CountIdentifiers, 1);
+    memcpy(s, ar + start, end - start);
+    s[end - start] = '\0';
+  }
+  (node->t).identifier = s;
+  if (sc->intern != NULL) {
+    node->id = internIdentifier(sc->intern, s, node->length);
+  }
+  return node;
+}
+
+List scanLine(Scanner *sc, char *ar, int length) {
+  struct ListNode head;
+  List last = &head;
+  int state = StateStart;
+  int start = 0;
+  int point = 0;
+  int next, cls, i;
+  assert(sc->arena != NULL || !sc->views);
+  TIMER_START(TimeScan);
+  head.next = NULL;
+  for (i = 0; i < length; i++) {
+    if (state == StateNumber && ar[i] == '.' && !point && i + 1 < length &&
+        charClass[(unsigned char)ar[i + 1]] == ClassDigit) {
+      point = 1;
+      continue;
+    }
+    cls = charClass[(unsigned char)ar[i]];
+    next = transition[state][cls];
+    if (next != state) {
+      if (state != StateStart) { /* a number or identifier ends here */
+        last->next = tokenNode(sc, ar, start, i, state);
+        last = last->next;
+        COUNT(CountTokens, 1);
+      }
+      start = i;
+      point = 0;
+    }
+    if (cls == ClassOther) {
+      last->next = allocNode(sc, 0);
+      last = last->next;
+      last->tt = Symbol;
+      (last->t).symbol = ar[i];
+      COUNT(CountTokens, 1);
+    }
+    state = next;
+  }
+  if (state != StateStart) {
+    last->next = tokenNode(sc, ar, start, length, state);
+    COUNT(CountTokens, 1);
+  }
+  TIMER_STOP(TimeScan);
+  return head.next;
+}
+
+#endif
+
+List tokenListSlice(char *ar, int length, Arena *a) {
+  Scanner sc;
+  initScanner(&sc, a);
+  return scanLine(&sc, ar, length);
+}
+
+List tokenListArena(char *ar, Arena *a) {
+  return tokenListSlice(ar, strlen(ar), a);
+}
+
+List tokenList(char *ar) {
+  return tokenListSlice(ar, strlen(ar), NULL);
+}
+
+/* The function fprintDecimal prints a decimal number with as few digits as give back the
+ * same double when it is read again: it tries 15, 16 and 17 significant digits, in that order,
+ * and 17 always suffice. %g drops trailing zeros, so 2.5 is printed as 2.5.
+ */
+
+void fprintDecimal(FILE *out, double w) {
+  char s[32];
+  int digits = 15;
+  sprintf(s, "%.15g", w);
+  while (digits < 17 && strtod(s, NULL) != w) {
+    digits++;
+    sprintf(s, "%.*g", digits, w);
+  }
+  fprintf(out, "%s", s);
+}
+
+/* The function fprintList prints the tokens in a token list on out, separated by spaces;
+ * printList prints them on standard output. A NumDecimal number is printed as it was written
+ * when its characters are known, see numberLiteral, so that 99999999999999999999 is not
+ * printed as 1e+20; only for a token file is it printed from its double.
+ */
+
+void fprintList(FILE *out, List li) {
   while (li != NULL) {
     switch (li->tt) {
     case Number:
-      printf("%d ", (li->t).number);
+      if (li->kind == NumInt) {
+        fprintf(out, "%d ", (li->t).number);
+      } else if (li->kind == NumLong) {
+        fprintf(out, "%lld ", (li->t).wide);
+      } else if (numberLiteral(li) != NULL) {
+        fprintf(out, "%.*s ", li->length, numberLiteral(li));
+      } else {
+        fprintDecimal(out, (li->t).decimal);
+        fprintf(out, " ");
+      }
       break;
     case Identifier:
-      printf("%s ", (li->t).identifier);
+      fprintf(out, "%.*s ", li->length, (li->t).identifier);
       break;
     case Symbol:
-      printf("%c ", (li->t).symbol);
+      fprintf(out, "%c ", (li->t).symbol);
       break;
     }
     li = li->next;
   }
-  printf("\n");
+  fprintf(out, "\n");
+}
+
+void printList(List li) {
+  fprintList(stdout, li);
 }
 
 /* The function freeTokenList frees the memory of the nodes of the list, and of the strings
- * in the nodes.
+ * in the nodes. It walks the list with a loop, so the stack it uses does not grow with the
+ * length of the list.
  */
 
 void freeTokenList(List li) {
-  if (li == NULL) {
-    return;
+  List next;
+  while (li != NULL) {
+    next = li->next;
+    if (li->tt == Identifier) {
+      free((li->t).identifier);
+    }
+    free(li);
+    li = next;
   }
-  if (li->tt == Identifier) {
-    free((li->t).identifier);
+}
+
+/* The function releaseLine frees an input line together with its token list.
+ * When the list has been made by tokenListArena, the arena a is reset in one step;
+ * otherwise a is NULL and the list is freed node by node.
+ */
+
+void releaseLine(char *ar, List li, Arena *a) {
+  if (a != NULL) {
+    resetArena(a);
+  } else {
+    freeTokenList(li);
   }
-  freeTokenList(li->next);
-  free(li);
+  free(ar);
 }
 
 /* The function scanExpressions is not in the lecture notes.
@@ -176,11 +559,11 @@ void scanExpressions() {
   while (ar[0] != '!') {
     li = tokenList(ar);
     printList(li);
-    free(ar);
-    freeTokenList(li);
+    releaseLine(ar, li, NULL);
     printf("\ngive an expression: ");
     ar = readInput();
   }
   free(ar);
   printf("good bye\n");
+  INSTRUMENT_DUMP(stderr);
 }
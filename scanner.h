@@ -3,6 +3,10 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 
+#include <stdio.h> /* FILE */
+#include "arena.h"
+#include "intern.h"
+
 #define MAXINPUT 100  /* maximal length of the input */
 #define MAXIDENT 10   /* maximal length of an identifier */
 
@@ -19,29 +23,82 @@ typedef enum TokenType {
   Symbol
 } TokenType;
 
+/* A number token has one of three kinds: NumInt for an integer that fits in an int, which is
+ * in the member number of the token; NumLong for a bigger integer that fits in a long long,
+ * in wide; and NumDecimal for a number with a fraction, like 2.5, or an integer that is too big
+ * even for a long long, in decimal. So large numbers do not wrap around.
+ */
+
+typedef enum NumberKind {
+  NumInt,
+  NumLong,
+  NumDecimal
+} NumberKind;
+
 typedef union Token {
   int number;
+  long long wide;
+  double decimal;
   char *identifier;
   char symbol;
 } Token;
 
 typedef struct ListNode *List;
 
+/* For a number, kind is its NumberKind; it is NumInt for the other tokens. For a NumDecimal
+ * number that the scanner has made, length is the number of characters with which it was
+ * written, which are kept behind the node, see numberLiteral; otherwise it is 0.
+ * For an identifier, length is the number of its characters, and id is its id in the
+ * intern table of the scanner that made the list, or -1 when the scanner had no intern table.
+ * The member identifier of t then points either to a copy of the identifier that is terminated
+ * by '\0', or, when the list has been made by a Scanner with views set, into the input line
+ * itself, where it is not terminated. Code that works for both cases uses length instead of
+ * strlen.
+ */
+
 typedef struct ListNode {
   TokenType tt;
+  NumberKind kind;
+  int length;
+  int id;
   Token t;
   List next;
 } ListNode;
 
+/* A Scanner describes how scanLine builds a token list:
+ * arena is the arena in which the nodes are allocated, or NULL for malloc;
+ * views is 1 when identifiers are not copied but point into the input line, which saves
+ * an allocation per identifier. Views are only allowed together with an arena, and the
+ * line must then live until the arena is reset;
+ * intern is the intern table that gives the identifiers their ids, or NULL.
+ */
+
+typedef struct Scanner {
+  Arena *arena;
+  int views;
+  InternTable *intern;
+} Scanner;
+
 /* Now the declaration of the functions that are defined in scanner.c
  * and are to be used outside it, e.g. in recognizeExp.c en in evalExp.c
  */
 
 char *readInput();
 List tokenList(char *array);
+List tokenListArena(char *array, Arena *a);
+List tokenListSlice(char *array, int length, Arena *a);
+void initScanner(Scanner *sc, Arena *a);
+List scanLine(Scanner *sc, char *array, int length);
+List newNode(char *array, int *ip, int length, Scanner *sc);
+NumberKind matchNumber(char *array, int *ip, int length, Token *tp);
+double numberValue(List l);
+const char *numberLiteral(List l);
 int valueNumber(List *lp, double *wp);
 void printList(List l);
+void fprintList(FILE *out, List l);
+void fprintDecimal(FILE *out, double w);
 void freeTokenList(List l);
+void releaseLine(char *array, List l, Arena *a);
 void scanExpressions();
 
 #endif
@@ -0,0 +1,144 @@
+/* server.c
+ *
+ * In this file the server mode of recog and eval is defined. Instead of a dialogue with a
+ * prompt before every line, the server reads the lines in batches: a batch is what has arrived
+ * of the input at once, see nextBatch in input.c. The answers to all lines of a batch are
+ * written into one output buffer of OUTPUTBLOCK bytes, which is flushed once per batch, so a
+ * large batch costs one write instead of several per line. The input is standard input, or the
+ * connections to a Unix socket, which are served one after the other.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* socket, fdopen, dup */
+
+#include <stdio.h>      /* fdopen, setvbuf, fflush, fclose, perror */
+#include <string.h>     /* memchr, strlen, strcpy */
+#include <errno.h>      /* errno, EINTR, ENAMETOOLONG, ENOENT, EEXIST */
+#include <signal.h>     /* signal, SIGPIPE */
+#include <unistd.h>     /* close, dup, unlink */
+#include <sys/stat.h>   /* lstat, S_ISSOCK */
+#include <sys/socket.h> /* socket, bind, listen, accept */
+#include <sys/un.h>     /* sockaddr_un */
+#include "input.h"
+#include "server.h"
+
+/* The function serveInput answers the lines of the input in with handle, batch by batch, and
+ * flushes out after every batch. It yields 1 when it stops at a line that starts with '!', as
+ * the dialogues do, and 0 at the end of the input.
+ */
+
+int serveInput(Input *in, FILE *out, LineHandler *handle, void *state) {
+  Line batch;
+  char *p, *end, *nl;
+  int length;
+  while (nextBatch(in, BATCHSIZE, &batch)) {
+    p = batch.start;
+    end = batch.start + batch.length;
+    while (p < end) {
+      nl = memchr(p, '\n', end - p);
+      length = (nl != NULL ? nl : end) - p;
+      if (length > 0 && p[0] == '!') {
+        fflush(out);
+        return 1;
+      }
+      handle(out, p, length, state);
+      p = p + length + 1;
+    }
+    fflush(out);
+  }
+  return 0;
+}
+
+/* The function removeStaleSocket removes what is left at path of an earlier server, so that
+ * bind can make the socket again. Only a socket is removed: it yields 0, with EEXIST in errno,
+ * when there is something else at path, and 1 otherwise.
+ */
+
+static int removeStaleSocket(const char *path) {
+  struct stat st;
+  if (lstat(path, &st) < 0) {
+    return errno == ENOENT;
+  }
+  if (!S_ISSOCK(st.st_mode)) {
+    errno = EEXIST;
+    return 0;
+  }
+  return unlink(path) == 0;
+}
+
+/* The function serveSocket listens on a Unix socket with the given path and serves its
+ * connections one at a time, each until its end, until a line that starts with '!' stops the
+ * server. A client that goes away early must not stop the server, so SIGPIPE is ignored.
+ * It yields 0 when the socket cannot be made, with the reason in errno, and 1 once it listens;
+ * when accept fails after that, the reason is printed here and the server stops. At the end
+ * the socket is removed, but only when path is still the socket that it made.
+ */
+
+static int serveSocket(const char *path, LineHandler *handle, void *state) {
+  struct sockaddr_un addr;
+  struct stat made, st;
+  Input in;
+  FILE *out;
+  int fd, conn;
+  int stop = 0;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return 0;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  if (!removeStaleSocket(path) || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      lstat(path, &made) < 0 || listen(fd, 16) < 0) {
+    close(fd);
+    return 0;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  while (!stop) {
+    conn = accept(fd, NULL, NULL);
+    if (conn < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("accept");
+      break;
+    }
+    out = fdopen(dup(conn), "w");
+    if (out == NULL) {
+      close(conn);
+      continue;
+    }
+    setvbuf(out, NULL, _IOFBF, OUTPUTBLOCK);
+    openInputFd(&in, conn);
+    stop = serveInput(&in, out, handle, state);
+    closeInput(&in);
+    fclose(out);
+  }
+  close(fd);
+  if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode) && st.st_dev == made.st_dev &&
+      st.st_ino == made.st_ino) {
+    unlink(path);
+  }
+  return 1;
+}
+
+/* The function serve answers lines with handle until a line that starts with '!', or until
+ * the end of the input: those of standard input on standard output when path is NULL, and
+ * otherwise those of the connections to the Unix socket path. It yields 0 when the socket
+ * cannot be made, with the reason in errno, and 1 otherwise.
+ */
+
+int serve(const char *path, LineHandler *handle, void *state) {
+  Input in;
+  if (path != NULL) {
+    return serveSocket(path, handle, state);
+  }
+  setvbuf(stdout, NULL, _IOFBF, OUTPUTBLOCK);
+  openInputFd(&in, 0);
+  serveInput(&in, stdout, handle, state);
+  closeInput(&in);
+  return 1;
+}
@@ -0,0 +1,21 @@
+/* server.h, a server mode that answers batches of lines without prompts */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h> /* FILE */
+#include "input.h"
+
+#define BATCHSIZE (1 << 16)    /* maximal size of the lines that are answered as one batch */
+#define OUTPUTBLOCK (1 << 20)  /* size of the output buffer of a batch */
+
+/* A LineHandler answers the line of the given length at ar on out; state is the state it
+ * needs, e.g. a RecogContext.
+ */
+
+typedef void LineHandler(FILE *out, char *ar, int length, void *state);
+
+int serveInput(Input *in, FILE *out, LineHandler *handle, void *state);
+int serve(const char *path, LineHandler *handle, void *state);
+
+#endif
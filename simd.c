@@ -0,0 +1,199 @@
+/* simd.c
+ *
+ * In this file the functions of simd.h are defined. Every vector version compares a block of
+ * bytes with the characters it looks for, turns the result into a bit mask with one bit per
+ * byte, and finds the first byte that does not match as the lowest bit set in the inverted
+ * mask. The bytes after the last whole block are handled by the plain loop, so nothing beyond
+ * length is read.
+ */
+
+#include <string.h> /* memcpy */
+#include "simd.h"
+
+#if !defined(NO_SIMD) && defined(__GNUC__) && defined(__AVX2__)
+#define SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(NO_SIMD) && defined(__GNUC__) && defined(__SSE2__)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#elif !defined(NO_SIMD) && defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__)
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+static int isSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static int isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+#if defined(SIMD_AVX2)
+
+/* The characters are compared as signed bytes; those above 127 are negative, so they are
+ * neither spaces nor digits.
+ */
+
+static unsigned spaceMask(const char *p) {
+  __m256i c = _mm256_loadu_si256((const __m256i *)p);
+  __m256i sp = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+                               _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('\t' - 1)),
+                                                _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), c)));
+  return (unsigned)_mm256_movemask_epi8(sp);
+}
+
+static unsigned digitMask(const char *p) {
+  __m256i c = _mm256_loadu_si256((const __m256i *)p);
+  __m256i d = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                               _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+  return (unsigned)_mm256_movemask_epi8(d);
+}
+
+#define BLOCK 32
+#define ALLSET 0xffffffffu
+
+#elif defined(SIMD_SSE2)
+
+static unsigned spaceMask(const char *p) {
+  __m128i c = _mm_loadu_si128((const __m128i *)p);
+  __m128i sp = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+                            _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('\t' - 1)),
+                                          _mm_cmplt_epi8(c, _mm_set1_epi8('\r' + 1))));
+  return (unsigned)_mm_movemask_epi8(sp);
+}
+
+static unsigned digitMask(const char *p) {
+  __m128i c = _mm_loadu_si128((const __m128i *)p);
+  __m128i d = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                            _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+  return (unsigned)_mm_movemask_epi8(d);
+}
+
+#define BLOCK 16
+#define ALLSET 0xffffu
+
+#elif defined(SIMD_NEON)
+
+/* NEON has no movemask: the comparison is narrowed to 4 bits per byte, which gives a 64 bit
+ * mask, and that is folded to one bit per byte.
+ */
+
+static unsigned foldMask(uint8x16_t m) {
+  uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+  unsigned mask = 0;
+  int k;
+  nibbles &= 0x1111111111111111ULL;
+  for (k = 0; k < 16; k++) {
+    mask |= (unsigned)(nibbles >> (4 * k) & 1) << k;
+  }
+  return mask;
+}
+
+static unsigned spaceMask(const char *p) {
+  uint8x16_t c = vld1q_u8((const uint8_t *)p);
+  uint8x16_t sp = vorrq_u8(vceqq_u8(c, vdupq_n_u8(' ')),
+                           vcleq_u8(vsubq_u8(c, vdupq_n_u8('\t')), vdupq_n_u8('\r' - '\t')));
+  return foldMask(sp);
+}
+
+static unsigned digitMask(const char *p) {
+  uint8x16_t c = vld1q_u8((const uint8_t *)p);
+  return foldMask(vcleq_u8(vsubq_u8(c, vdupq_n_u8('0')), vdupq_n_u8(9)));
+}
+
+#define BLOCK 16
+#define ALLSET 0xffffu
+
+#endif
+
+int skipSpaces(const char *ar, int i, int length) {
+#ifdef BLOCK
+  unsigned m;
+  while (i + BLOCK <= length) {
+    m = spaceMask(ar + i) ^ ALLSET;
+    if (m != 0) {
+      return i + __builtin_ctz(m);
+    }
+    i += BLOCK;
+  }
+#endif
+  while (i < length && isSpace(ar[i])) {
+    i++;
+  }
+  return i;
+}
+
+int skipDigits(const char *ar, int i, int length) {
+#ifdef BLOCK
+  unsigned m;
+  while (i + BLOCK <= length) {
+    m = digitMask(ar + i) ^ ALLSET;
+    if (m != 0) {
+      return i + __builtin_ctz(m);
+    }
+    i += BLOCK;
+  }
+#endif
+  while (i < length && isDigit(ar[i])) {
+    i++;
+  }
+  return i;
+}
+
+/* The function eightDigits computes the value of n <= 8 digits at s with SWAR: three
+ * multiplications that combine pairs of digits, pairs of pairs and pairs of quadruples in the
+ * lanes of one 64 bit word. The first digit is in the lowest byte, so this needs a little
+ * endian machine. When 8 bytes may be read at s, they are loaded at once and the bytes after
+ * the digits are shifted out, which leaves zeros in front; xor with '0' turns a digit into its
+ * value without borrowing from the next byte, as a subtraction would for the other bytes.
+ */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+static unsigned eightDigits(const char *s, int n, int avail) {
+  unsigned long long v = 0x3030303030303030ULL;
+  if (avail >= 8) {
+    memcpy(&v, s, 8);
+  } else {
+    memcpy(&v, s, n);
+  }
+  v ^= 0x3030303030303030ULL;
+  v <<= 8 * (8 - n);
+  v = (v * 10 + (v >> 8)) & 0x00ff00ff00ff00ffULL;
+  v = (v * 100 + (v >> 16)) & 0x0000ffff0000ffffULL;
+  v = (v * 10000 + (v >> 32)) & 0xffffffffULL;
+  return (unsigned)v;
+}
+
+#else
+
+static unsigned eightDigits(const char *s, int n, int avail) {
+  unsigned v = 0;
+  int i;
+  for (i = 0; i < n; i++) {
+    v = 10 * v + (s[i] - '0');
+  }
+  return v;
+}
+
+#endif
+
+/* The function digitsValue yields the value of the n >= 1 digits at s, where avail >= n bytes
+ * may be read. The value is computed modulo 2^64, so it is exact for up to 19 digits.
+ */
+
+unsigned long long digitsValue(const char *s, int n, int avail) {
+  int k = (n - 1) % 8 + 1;
+  unsigned long long v = eightDigits(s, k, avail);
+  s += k;
+  n -= k;
+  avail -= k;
+  while (n > 0) {
+    v = v * 100000000u + eightDigits(s, 8, avail);
+    s += 8;
+    n -= 8;
+    avail -= 8;
+  }
+  return v;
+}
@@ -0,0 +1,18 @@
+/* simd.h, skipping spaces and digits many bytes at a time */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+/* The functions skipSpaces and skipDigits yield the index of the first character at or after
+ * index i of ar that is not a space, or not a digit, or length when there is none. Spaces are
+ * the characters for which isspace holds in the "C" locale. They use SSE2 or AVX2 on x86 and
+ * NEON on ARM, 16 or 32 bytes at a time; with NO_SIMD defined, or on other machines, a plain
+ * loop. The function digitsValue yields the value of the n >= 1 digits at s, 8 digits at a
+ * time, modulo 2^64; avail >= n is the number of bytes that may be read at s.
+ */
+
+int skipSpaces(const char *ar, int i, int length);
+int skipDigits(const char *ar, int i, int length);
+unsigned long long digitsValue(const char *s, int n, int avail);
+
+#endif
@@ -0,0 +1,397 @@
+/* solve.c
+ *
+ * In this file the real roots of polynomials in one variable are computed: with the closed
+ * form for degree 2, and with Newton's method for higher degrees, where the polynomial and
+ * its derivative are evaluated with Horner's scheme. Nothing is allocated: the caller gives
+ * the memory for the intermediate polynomials and the roots.
+ */
+
+#include <math.h>  /* sqrt, copysign, fabs, isfinite, pow */
+#include <float.h> /* DBL_EPSILON */
+#include "solve.h"
+
+#define MAXITER 100     /* Newton steps from one starting point */
+#define EPSILON 1e-14   /* relative size of the last Newton step at convergence */
+#define SAMPLES 8       /* points per degree at which sampleRoot looks for a change of sign */
+#define MAXSAMPLES 1024 /* but not more than this many */
+
+/* The function solveQuadratic computes the real roots of a x^2 + b x + c, where a != 0.
+ * It yields their number: 2 with x1 < x2, 1 for a double root x1 = x2, or 0.
+ * The root that is far from 0 is computed first and the other one as c / (a x1), so that
+ * no precision is lost when b*b is much bigger than 4ac.
+ */
+
+int solveQuadratic(double a, double b, double c, double *x1, double *x2) {
+  double d = b * b - 4 * a * c;
+  double q, h;
+  if (d < 0) {
+    return 0;
+  }
+  if (d == 0) {
+    *x1 = *x2 = -0.5 * b / a;
+    return 1;
+  }
+  q = -0.5 * (b + copysign(sqrt(d), b));
+  *x1 = q / a;
+  *x2 = c / q;
+  if (*x1 > *x2) {
+    h = *x1;
+    *x1 = *x2;
+    *x2 = h;
+  }
+  return 2;
+}
+
+/* The function solveQuadraticBatch solves a[i] x^2 + b[i] x + c[i] = 0 for 0 <= i < n, with
+ * the roots in x1[i] <= x2[i], or NaN in both when there is no real root. The loop has no
+ * branches that depend on the data, so with the flags of BENCHFLAGS in the Makefile, which
+ * allow sqrt and comparisons without errno and traps, it is vectorized and runs at the speed
+ * of memory.
+ */
+
+void solveQuadraticBatch(const double *a, const double *b, const double *c,
+                         double *x1, double *x2, size_t n) {
+  size_t i;
+  double d, s, q, r1, r2;
+  for (i = 0; i < n; i++) {
+    d = b[i] * b[i] - 4 * a[i] * c[i];
+    s = sqrt(d); /* NaN when d < 0, and then so are the roots */
+    q = -0.5 * (b[i] + copysign(s, b[i]));
+    r1 = q / a[i];
+    r2 = c[i] / q;
+    r2 = (d == 0 ? r1 : r2); /* q is 0 only when d is 0 */
+    x1[i] = (r1 < r2 ? r1 : r2);
+    x2[i] = (r1 < r2 ? r2 : r1);
+  }
+}
+
+/* The function horner computes the value of the polynomial c[0] + c[1] x + ... + c[n] x^n
+ * and stores the value of its derivative in *dp.
+ */
+
+static double horner(const double *c, int n, double x, double *dp) {
+  double p = c[n];
+  double d = 0;
+  int i;
+  for (i = n - 1; i >= 0; i--) {
+    d = d * x + p;
+    p = p * x + c[i];
+  }
+  *dp = d;
+  return p;
+}
+
+/* The function bracketed finds a root between lo and hi, where the polynomial has values of
+ * opposite signs. A Newton step that would leave the bracket is replaced by bisection, so it
+ * always converges.
+ */
+
+static double bracketed(const double *c, int n, double lo, double hi) {
+  double d, f, x, y;
+  int i;
+  if (horner(c, n, lo, &d) > 0) { /* orient so that the value at lo is negative */
+    x = lo;
+    lo = hi;
+    hi = x;
+  }
+  x = 0.5 * (lo + hi);
+  for (i = 0; i < 10 * MAXITER; i++) {
+    f = horner(c, n, x, &d);
+    if (f == 0) {
+      return x;
+    }
+    if (f < 0) {
+      lo = x;
+    } else {
+      hi = x;
+    }
+    y = x - f / d;
+    if (d == 0 || !((y > lo && y < hi) || (y > hi && y < lo))) {
+      y = 0.5 * (lo + hi);
+    }
+    if (fabs(y - x) <= EPSILON * (fabs(x) > 1 ? fabs(x) : 1)) {
+      return y;
+    }
+    x = y;
+  }
+  return x;
+}
+
+/* The function newton tries Newton's method from x. It yields 1 when the steps become
+ * small enough, with the root in *xp, and 0 when they do not converge. Near a multiple root
+ * the steps shrink only linearly and then stall at the rounding errors, so after MAXITER steps
+ * a last step of relative size 1e-7 is also taken to be convergence.
+ */
+
+static int newton(const double *c, int n, double x, double *xp) {
+  double d, f, dx;
+  int i;
+  for (i = 0; i < MAXITER; i++) {
+    f = horner(c, n, x, &d);
+    if (f == 0) {
+      *xp = x;
+      return 1;
+    }
+    if (d == 0 || !isfinite(f) || !isfinite(d)) {
+      return 0;
+    }
+    dx = f / d;
+    x -= dx;
+    if (fabs(dx) <= EPSILON * (fabs(x) > 1 ? fabs(x) : 1)) {
+      *xp = x;
+      return 1;
+    }
+  }
+  *xp = x;
+  return fabs(dx) <= 1e-7 * (fabs(x) > 1 ? fabs(x) : 1);
+}
+
+/* The function vanishes yields 1 when the value of the polynomial c of degree n at x is not
+ * bigger than the rounding errors of Horner's scheme, which are bounded by the value of the
+ * polynomial with the absolute values of the coefficients at |x|, times 2n units in the last
+ * place; such a value cannot be told apart from 0.
+ */
+
+static int vanishes(const double *c, int n, double x) {
+  double p = fabs(c[n]);
+  double d;
+  int i;
+  for (i = n - 1; i >= 0; i--) {
+    p = p * fabs(x) + fabs(c[i]);
+  }
+  return fabs(horner(c, n, x, &d)) <= 2 * n * DBL_EPSILON * p;
+}
+
+/* The function sampleRoot looks for a real root of the polynomial c of degree n in [-r, r],
+ * when Newton's method from 0, r and -r has failed, at SAMPLES * n + 1 points spaced evenly,
+ * or MAXSAMPLES + 1 for a high degree, and at the points +-r/2^k, which see the roots that lie close to 0 when r is big. A point
+ * where the value has the other sign than at r gives a bracket. Without one, the real roots
+ * can only be roots of even multiplicity, where the value touches 0, so Newton is tried from
+ * the points where the absolute value is smaller than at both neighbours.
+ */
+
+static int sampleRoot(const double *c, int n, double r, double *xp) {
+  double d0, f, prev, next, x;
+  int m = (n < MAXSAMPLES / SAMPLES ? SAMPLES * n : MAXSAMPLES);
+  int negative = (horner(c, n, r, &d0) < 0);
+  int i;
+  for (i = 0; i <= m; i++) {
+    x = -r + 2 * r * i / m;
+    f = horner(c, n, x, &d0);
+    if (f == 0) {
+      *xp = x;
+      return 1;
+    }
+    if ((f < 0) != negative) {
+      *xp = bracketed(c, n, x, r);
+      return 1;
+    }
+  }
+  for (x = 0.5 * r; x > 0 && x > DBL_EPSILON * r; x = 0.5 * x) {
+    if ((horner(c, n, x, &d0) < 0) != negative) {
+      *xp = bracketed(c, n, x, r);
+      return 1;
+    }
+    if ((horner(c, n, -x, &d0) < 0) != negative) {
+      *xp = bracketed(c, n, -x, r);
+      return 1;
+    }
+  }
+  prev = fabs(horner(c, n, -r, &d0));
+  f = fabs(horner(c, n, -r + 2 * r / m, &d0));
+  for (i = 1; i < m; i++) {
+    next = fabs(horner(c, n, -r + 2 * r * (i + 1) / m, &d0));
+    if (f < prev && f < next && newton(c, n, -r + 2 * r * i / m, xp) && vanishes(c, n, *xp)) {
+      return 1;
+    }
+    prev = f;
+    f = next;
+  }
+  return 0;
+}
+
+/* The function findRoot finds a real root of the polynomial c of degree n. All real roots lie
+ * in [-r, r], with r the bound of Fujiwara, which is at most 2n times the largest absolute
+ * value of a root, so that the samples of sampleRoot are not spread too thin. When the values
+ * at -r and r differ in sign, which is always the case for odd n, there is a bracket;
+ * otherwise Newton is tried from 0, r and -r, and when it fails there, sampleRoot looks for
+ * a bracket.
+ */
+
+static int findRoot(const double *c, int n, double *xp) {
+  double r = 0;
+  double d, h;
+  int i;
+  for (i = 1; i <= n; i++) {
+    h = pow(fabs(c[n - i] / c[n]) / (i == n ? 2 : 1), 1.0 / i);
+    if (h > r) {
+      r = h;
+    }
+  }
+  r = 2 * r;
+  if (r == 0) { /* c is c[n] x^n */
+    *xp = 0;
+    return 1;
+  }
+  if ((horner(c, n, -r, &d) < 0) != (horner(c, n, r, &d) < 0)) {
+    *xp = bracketed(c, n, -r, r);
+    return 1;
+  }
+  return newton(c, n, 0, xp) || newton(c, n, r, xp) || newton(c, n, -r, xp) ||
+         sampleRoot(c, n, r, xp);
+}
+
+/* The function deflate divides the polynomial c of degree n by (x - x0), with Horner's
+ * scheme; the remainder is dropped.
+ */
+
+static void deflate(double *c, int n, double x0) {
+  double carry = c[n];
+  double h;
+  int i;
+  for (i = n - 1; i >= 0; i--) {
+    h = c[i];
+    c[i] = carry;
+    carry = h + carry * x0;
+  }
+}
+
+static void sortRoots(double *roots, int n) {
+  double h;
+  int i, j;
+  for (i = 1; i < n; i++) { /* insertion sort: there are few real roots */
+    h = roots[i];
+    for (j = i; j > 0 && roots[j - 1] > h; j--) {
+      roots[j] = roots[j - 1];
+    }
+    roots[j] = h;
+  }
+}
+
+/* The function polish takes a few Newton steps from the root x of the polynomial c of degree
+ * n, as long as they make the value of the polynomial smaller, and yields the result.
+ */
+
+static double polish(const double *c, int n, double x) {
+  double d, f, y;
+  int i;
+  for (i = 0; i < 3; i++) {
+    f = horner(c, n, x, &d);
+    y = (d != 0 ? x - f / d : x);
+    if (!isfinite(y) || fabs(horner(c, n, y, &d)) > fabs(f)) {
+      break;
+    }
+    x = y;
+  }
+  return x;
+}
+
+/* The function clustered yields 1 when the neighbouring roots x <= y of the polynomial c of
+ * degree n are taken to be one multiple root: when both the polynomial and its derivative
+ * vanish at their midpoint, which they do not between separate roots. A root of multiplicity m
+ * is only found up to about the m-th root of the rounding errors, so the roots of a cluster can
+ * be much further apart than their digits suggest. work has room for n numbers.
+ */
+
+static int clustered(const double *c, int n, double x, double y, double *work) {
+  double m = 0.5 * (x + y);
+  int i;
+  if (!vanishes(c, n, m)) {
+    return 0;
+  }
+  for (i = 1; i <= n; i++) {
+    work[i - 1] = i * c[i];
+  }
+  return vanishes(work, n - 1, m);
+}
+
+/* The function refine improves the root x of the polynomial c of degree n when it is a
+ * multiple root. A root of multiplicity m is a simple root of the m - 1-th derivative, where
+ * Newton's method finds it to full precision, so Newton's method is tried on the derivatives
+ * one after the other, for as long as the polynomial still vanishes at the point found and that
+ * point stays within 1% of x. work has room for n + 1 numbers.
+ */
+
+static double refine(const double *c, int n, double x, double *work) {
+  double y;
+  int i, k;
+  for (i = 0; i <= n; i++) {
+    work[i] = c[i];
+  }
+  for (k = n; k > 1; k--) {
+    for (i = 1; i <= k; i++) { /* the next derivative, of degree k - 1 */
+      work[i - 1] = i * work[i];
+    }
+    y = x;
+    newton(work, k - 1, x, &y);
+    if (!vanishes(c, n, y) || fabs(y - x) > 1e-2 * (fabs(x) > 1 ? fabs(x) : 1)) {
+      break;
+    }
+    x = y;
+  }
+  return x;
+}
+
+/* The function solvePolynomial computes the distinct real roots of the polynomial
+ * coef[0] + coef[1] x + ... + coef[degree] x^degree, where coef[degree] != 0, and yields
+ * their number. They are stored in ascending order in roots, which has room for degree
+ * numbers; work has room for degree + 1 numbers. Every root found is polished with a few
+ * Newton steps on the original polynomial and then divided out. What is left of degree 2 is
+ * solved in closed form; after deflation a double root may come out with a discriminant that
+ * is slightly negative, which is taken to be 0. The roots from the closed form are polished as
+ * well, the multiple roots are refined, and the roots that clustered takes to be one multiple
+ * root are reported once. Without deflation the roots are exact and distinct, those of the
+ * closed form as well as 0, so they are not merged.
+ */
+
+int solvePolynomial(const double *coef, int degree, double *work, double *roots) {
+  int nroots = 0;
+  int deflated = 0;
+  int n = degree;
+  int i, j, k, closed;
+  double x, d;
+  while (n > 0 && coef[degree - n] == 0) { /* x^k divides the polynomial: 0 is a root */
+    n--;
+  }
+  if (n < degree) {
+    roots[nroots++] = 0;
+  }
+  for (i = 0; i <= n; i++) {
+    work[i] = coef[degree - n + i];
+  }
+  while (n > 2 && findRoot(work, n, &x)) {
+    x = polish(coef, degree, x);
+    roots[nroots++] = x;
+    deflate(work, n, x);
+    deflated = 1;
+    n--;
+  }
+  closed = nroots;
+  if (n == 2) {
+    d = work[1] * work[1] - 4 * work[2] * work[0];
+    if (d < 0 && -d <= 1e-9 * work[1] * work[1] && deflated) {
+      roots[nroots++] = -work[1] / (2 * work[2]);
+    } else {
+      nroots += solveQuadratic(work[2], work[1], work[0], &roots[nroots], &roots[nroots + 1]);
+    }
+  } else if (n == 1) {
+    roots[nroots++] = -work[0] / work[1];
+  }
+  for (i = closed; i < nroots; i++) {
+    roots[i] = polish(coef, degree, roots[i]);
+  }
+  for (i = 0; i < nroots; i++) {
+    roots[i] = refine(coef, degree, roots[i], work);
+  }
+  sortRoots(roots, nroots);
+  k = 0;
+  for (i = 0; i < nroots; i = j) {
+    x = roots[i];
+    for (j = i + 1; j < nroots && deflated &&
+         clustered(coef, degree, roots[j - 1], roots[j], work); j++) {
+      x += roots[j];
+    }
+    roots[k++] = x / (j - i);
+  }
+  return k;
+}
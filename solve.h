@@ -0,0 +1,13 @@
+/* solve.h, real roots of polynomials in one variable */
+
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include <stddef.h> /* size_t */
+
+int solveQuadratic(double a, double b, double c, double *x1, double *x2);
+void solveQuadraticBatch(const double *a, const double *b, const double *c,
+                         double *x1, double *x2, size_t n);
+int solvePolynomial(const double *coef, int degree, double *work, double *roots);
+
+#endif
@@ -0,0 +1,196 @@
+/* stream.c
+ *
+ * In this file the incremental scanner of stream.h is defined. It makes the tokens with
+ * newNode of scanner.c, so they are the same as those of scanLine. A token that lies
+ * completely in the current chunk is made from the chunk directly; only a number or identifier
+ * that reaches the end of the chunk is copied to the pending buffer, where it is completed
+ * with the characters of the next chunks.
+ */
+
+#include <stdlib.h> /* NULL, malloc, realloc, free */
+#include <string.h> /* memcpy */
+#include <ctype.h>  /* isspace, isdigit, isalpha, isalnum */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "simd.h"
+#include "stream.h"
+#include "instrument.h"
+
+#define PENDINGSIZE 64 /* initial size of the pending buffer */
+
+void initStreamScanner(StreamScanner *ss, Scanner *sc) {
+  assert(!sc->views);
+  ss->scanner = sc;
+  ss->chunk = NULL;
+  ss->length = 0;
+  ss->pos = 0;
+  ss->pending = NULL;
+  ss->npending = 0;
+  ss->capacity = 0;
+  ss->pendingColumn = 0;
+  ss->next = 0;
+  ss->column = 0;
+  ss->finished = 0;
+}
+
+void freeStreamScanner(StreamScanner *ss) {
+  free(ss->pending);
+  ss->pending = NULL;
+  ss->capacity = 0;
+}
+
+/* The function feedStream makes chunk[0..length-1] the input of the scanner; it may only be
+ * called when the previous chunk has been used up. After endStream no more input follows,
+ * so a pending token is complete.
+ */
+
+void feedStream(StreamScanner *ss, char *chunk, int length) {
+  assert(ss->pos == ss->length && !ss->finished);
+  ss->chunk = chunk;
+  ss->length = length;
+  ss->pos = 0;
+}
+
+void endStream(StreamScanner *ss) {
+  ss->chunk = NULL;
+  ss->length = 0;
+  ss->pos = 0;
+  ss->finished = 1;
+}
+
+/* The function appendPending appends ar[0..n-1] to the pending buffer, whose size is
+ * doubled when necessary, as in readInput.
+ */
+
+static void appendPending(StreamScanner *ss, char *ar, int n) {
+  if (ss->npending + n > ss->capacity) {
+    if (ss->capacity == 0) {
+      ss->capacity = PENDINGSIZE;
+    }
+    while (ss->npending + n > ss->capacity) {
+      ss->capacity = 2 * ss->capacity;
+    }
+    ss->pending = realloc(ss->pending, ss->capacity);
+    assert(ss->pending != NULL);
+  }
+  memcpy(ss->pending + ss->npending, ar, n);
+  ss->npending = ss->npending + n;
+}
+
+/* The function tokenEnd yields the end of the token that starts at ar[i], which is not a space,
+ * or -1 when the token may go on in the next chunk: a number or identifier that reaches the end
+ * of the chunk, or a number followed by a '.' that is the last character of the chunk, since
+ * only the next character tells whether that '.' is a decimal point.
+ */
+
+static int tokenEnd(char *ar, int i, int length) {
+  int j = i;
+  if (isdigit(ar[i])) {
+    j = skipDigits(ar, i, length);
+    if (j + 1 == length && ar[j] == '.') {
+      return -1;
+    }
+    if (j + 1 < length && ar[j] == '.' && isdigit(ar[j + 1])) {
+      j = skipDigits(ar, j + 1, length);
+    }
+  } else if (isalpha(ar[i])) {
+    while (j < length && isalnum(ar[j])) {
+      j++;
+    }
+  } else {
+    return i + 1;
+  }
+  return (j == length ? -1 : j);
+}
+
+/* The function extendPending appends to the pending number or identifier the characters of
+ * the chunk that continue it. A number may get one '.', which is tentative as long as it is
+ * the last character: the number then goes on only when a digit follows.
+ */
+
+static void extendPending(StreamScanner *ss) {
+  int start = ss->pos;
+  int identifier = isalpha(ss->pending[0]);
+  int point = (memchr(ss->pending, '.', ss->npending) != NULL);
+  char c;
+  while (ss->pos < ss->length) {
+    c = ss->chunk[ss->pos];
+    if (identifier ? !isalnum(c) : !isdigit(c) && (c != '.' || point)) {
+      break;
+    }
+    point = point || c == '.';
+    ss->pos++;
+  }
+  if (ss->pos > start) {
+    appendPending(ss, ss->chunk + start, ss->pos - start);
+    ss->next = ss->next + (ss->pos - start);
+  }
+}
+
+/* The function pendingToken makes the token of the complete pending buffer. When it ends
+ * with a '.' that has turned out not to be a decimal point, that '.' stays behind in the
+ * buffer and is the next token.
+ */
+
+static List pendingToken(StreamScanner *ss) {
+  int k = 0;
+  List node = newNode(ss->pending, &k, ss->npending, ss->scanner);
+  ss->column = ss->pendingColumn;
+  if (k < ss->npending) {
+    ss->pending[0] = ss->pending[k];
+    ss->npending = ss->npending - k;
+    ss->pendingColumn = ss->pendingColumn + k;
+  } else {
+    ss->npending = 0;
+  }
+  return node;
+}
+
+StreamResult nextToken(StreamScanner *ss, List *tp) {
+  char *ar = ss->chunk;
+  int start, end;
+  if (ss->npending > 0) {
+    if (isalnum(ss->pending[0])) {
+      extendPending(ss);
+      if (ss->pos == ss->length && !ss->finished) {
+        return StreamNeedInput;
+      }
+    }
+    *tp = pendingToken(ss);
+    COUNT(CountTokens, 1);
+    return StreamToken;
+  }
+  while (ss->pos < ss->length && ar[ss->pos] != '\n' && isspace(ar[ss->pos])) {
+    ss->pos++;
+    ss->next++;
+  }
+  if (ss->pos == ss->length) {
+    if (!ss->finished) {
+      return StreamNeedInput;
+    }
+    if (ss->next > 0) { /* a last line without '\n' */
+      ss->next = 0;
+      return StreamEndOfLine;
+    }
+    return StreamEnd;
+  }
+  if (ar[ss->pos] == '\n') {
+    ss->pos++;
+    ss->next = 0;
+    return StreamEndOfLine;
+  }
+  start = ss->pos;
+  end = tokenEnd(ar, start, ss->length);
+  if (end < 0) { /* the token may go on in the next chunk */
+    appendPending(ss, ar + start, ss->length - start);
+    ss->pendingColumn = ss->next;
+    ss->next = ss->next + (ss->length - start);
+    ss->pos = ss->length;
+    return StreamNeedInput;
+  }
+  *tp = newNode(ar, &ss->pos, end, ss->scanner);
+  ss->column = ss->next;
+  ss->next = ss->next + (ss->pos - start);
+  COUNT(CountTokens, 1);
+  return StreamToken;
+}
@@ -0,0 +1,50 @@
+/* stream.h, incremental scanning of input that arrives in chunks */
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "scanner.h"
+
+/* A StreamScanner makes the same tokens as scanLine, but the input is pushed into it in chunks
+ * of any size, e.g. as they arrive from a pipe or a socket: a line need not be complete before
+ * its first tokens are made. feedStream hands it the next chunk, and nextToken yields the next
+ * token of the chunk in *tp, together with a StreamResult:
+ * StreamToken when *tp is a token, which is allocated by the scanner as in scanLine;
+ * StreamEndOfLine at a '\n', and at the end of a last line without '\n';
+ * StreamNeedInput when the chunk has been used up, so the next chunk must be fed;
+ * StreamEnd when endStream has been called and all tokens have been yielded.
+ * A number or identifier that is cut off by the end of a chunk is kept in pending until the
+ * next chunk shows where it ends, so only the tokens themselves are buffered, never a line.
+ * The chunk must live until nextToken yields StreamNeedInput; the tokens do not point into it,
+ * so the scanner must not have views. column is the position in the current line of the
+ * start of the last token.
+ */
+
+typedef enum StreamResult {
+  StreamToken,
+  StreamEndOfLine,
+  StreamNeedInput,
+  StreamEnd
+} StreamResult;
+
+typedef struct StreamScanner {
+  Scanner *scanner;
+  char *chunk;
+  int length;
+  int pos;
+  char *pending;   /* the start of a number or identifier that is cut off by a chunk */
+  int npending;
+  int capacity;
+  int pendingColumn;
+  int next;        /* position in the current line of the next character */
+  int column;
+  int finished;
+} StreamScanner;
+
+void initStreamScanner(StreamScanner *ss, Scanner *sc);
+void freeStreamScanner(StreamScanner *ss);
+void feedStream(StreamScanner *ss, char *chunk, int length);
+void endStream(StreamScanner *ss);
+StreamResult nextToken(StreamScanner *ss, List *tp);
+
+#endif
@@ -0,0 +1,158 @@
+/* tokenArray.c
+ *
+ * In this file a second representation of the scanned tokens is defined: a token array
+ * with parallel arrays for the token types and values. Walking over it with a cursor
+ * touches consecutive memory, where walking over a token list follows a pointer for every
+ * token. The tokens are the same as those produced by tokenList in scanner.c.
+ */
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* NULL, realloc, free */
+#include <string.h> /* strlen */
+#include <ctype.h>  /* isspace, isdigit, isalpha, isalnum */
+#include <assert.h> /* assert */
+#include "tokenArray.h"
+#include "instrument.h"
+
+void initTokenArray(TokenArray *ta) {
+  ta->tt = NULL;
+  ta->value = NULL;
+  ta->ident = NULL;
+  ta->src = NULL;
+  ta->length = 0;
+  ta->capacity = 0;
+  ta->numbers = NULL;
+  ta->nnumbers = 0;
+  ta->numbersCapacity = 0;
+}
+
+/* The function addToken appends a token to the token array; the arrays are doubled
+ * when they are full.
+ */
+
+static void addToken(TokenArray *ta, TokenType tt, int value, int ident) {
+  if (ta->length == ta->capacity) {
+    ta->capacity = (ta->capacity == 0 ? MAXINPUT : 2 * ta->capacity);
+    ta->tt = realloc(ta->tt, ta->capacity * sizeof(unsigned char));
+    ta->value = realloc(ta->value, ta->capacity * sizeof(int));
+    ta->ident = realloc(ta->ident, ta->capacity * sizeof(int));
+    assert(ta->tt != NULL && ta->value != NULL && ta->ident != NULL);
+  }
+  ta->tt[ta->length] = tt;
+  ta->value[ta->length] = value;
+  ta->ident[ta->length] = ident;
+  ta->length++;
+  COUNT(CountTokens, 1);
+}
+
+/* The function addNumber appends a number token of the given kind. */
+
+static void addNumber(TokenArray *ta, NumberKind kind, Token t) {
+  if (kind == NumInt) {
+    addToken(ta, Number, t.number, -1);
+    return;
+  }
+  if (ta->nnumbers == ta->numbersCapacity) {
+    ta->numbersCapacity = (ta->numbersCapacity == 0 ? 16 : 2 * ta->numbersCapacity);
+    ta->numbers = realloc(ta->numbers, ta->numbersCapacity * sizeof(Token));
+    assert(ta->numbers != NULL);
+  }
+  ta->numbers[ta->nnumbers] = t;
+  addToken(ta, Number, kind, ta->nnumbers);
+  ta->nnumbers++;
+}
+
+/* The function scanTokenArray reads an array and puts the tokens that are read in the
+ * token array, replacing its previous contents. Numbers are read by matchNumber of scanner.c.
+ */
+
+void scanTokenArray(TokenArray *ta, char *ar) {
+  int length = strlen(ar);
+  int i = 0;
+  int j;
+  NumberKind kind;
+  Token t;
+  ta->src = ar;
+  ta->length = 0;
+  ta->nnumbers = 0;
+  while (ar[i] != '\0') {
+    if (isspace(ar[i])) { /* spaces are skipped */
+      i++;
+    } else if (isdigit(ar[i])) { /* a number */
+      kind = matchNumber(ar, &i, length, &t);
+      addNumber(ta, kind, t);
+    } else if (isalpha(ar[i])) { /* an identifier */
+      j = i;
+      while (isalnum(ar[i])) {
+        i++;
+      }
+      addToken(ta, Identifier, i - j, j);
+    } else { /* a symbol */
+      addToken(ta, Symbol, ar[i], -1);
+      i++;
+    }
+  }
+}
+
+/* The function printTokenArray prints the tokens in the same way as printList.
+ */
+
+void printTokenArray(TokenArray *ta) {
+  int i;
+  for (i = 0; i < ta->length; i++) {
+    switch (ta->tt[i]) {
+    case Number:
+      if (ta->ident[i] < 0) {
+        printf("%d ", ta->value[i]);
+      } else if (ta->value[i] == NumLong) {
+        printf("%lld ", ta->numbers[ta->ident[i]].wide);
+      } else {
+        fprintDecimal(stdout, ta->numbers[ta->ident[i]].decimal);
+        printf(" ");
+      }
+      break;
+    case Identifier:
+      printf("%.*s ", ta->value[i], ta->src + ta->ident[i]);
+      break;
+    case Symbol:
+      printf("%c ", ta->value[i]);
+      break;
+    }
+  }
+  printf("\n");
+}
+
+void freeTokenArray(TokenArray *ta) {
+  free(ta->tt);
+  free(ta->value);
+  free(ta->ident);
+  free(ta->numbers);
+  initTokenArray(ta);
+}
+
+void initCursor(Cursor *cp, const TokenArray *ta) {
+  cp->tt = ta->tt;
+  cp->value = ta->value;
+  cp->ident = ta->ident;
+  cp->numbers = ta->numbers;
+  cp->pos = 0;
+  cp->length = ta->length;
+}
+
+/* The function cursorAtEnd yields 1 when all tokens have been consumed, like a List
+ * pointer that has become NULL.
+ */
+
+int cursorAtEnd(Cursor *cp) {
+  return cp->pos >= cp->length;
+}
+
+/* The function cursorNumber yields the value of the number token at the cursor as a double. */
+
+double cursorNumber(Cursor *cp) {
+  int k = cp->ident[cp->pos];
+  if (k < 0) {
+    return cp->value[cp->pos];
+  }
+  return (cp->value[cp->pos] == NumLong ? (double)cp->numbers[k].wide : cp->numbers[k].decimal);
+}
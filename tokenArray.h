@@ -0,0 +1,53 @@
+/* tokenArray.h, contiguous token buffer with a cursor */
+
+#ifndef TOKENARRAY_H
+#define TOKENARRAY_H
+
+#include "scanner.h"
+
+/* A token array holds the tokens of one line in parallel arrays instead of a list:
+ * tt[i] is the TokenType of token i;
+ * value[i] is its number, its symbol character or, for an identifier, its length;
+ * ident[i] is the offset of an identifier in src, and -1 for the other tokens, except for
+ * numbers that do not fit in an int (see NumberKind in scanner.h): then ident[i] is the index
+ * of the number in numbers and value[i] is its kind, NumLong or NumDecimal, which tells whether
+ * it is held in the member wide or decimal, so that a big integer keeps all its digits.
+ * The identifiers are not copied, so src must live as long as the token array is used.
+ * The arrays are reused when the next line is scanned into the same token array.
+ */
+
+typedef struct TokenArray {
+  unsigned char *tt;
+  int *value;
+  int *ident;
+  char *src;
+  int length;
+  int capacity;
+  Token *numbers;
+  int nnumbers;
+  int numbersCapacity;
+} TokenArray;
+
+/* A cursor is a position in a token array; it plays the role of the List pointer
+ * that is passed to the accept and value functions. It has its own copies of the
+ * array pointers, so that a step does not have to go through the token array.
+ */
+
+typedef struct Cursor {
+  const unsigned char *tt;
+  const int *value;
+  const int *ident;
+  const Token *numbers;
+  int pos;
+  int length;
+} Cursor;
+
+void initTokenArray(TokenArray *ta);
+void scanTokenArray(TokenArray *ta, char *ar);
+void printTokenArray(TokenArray *ta);
+void freeTokenArray(TokenArray *ta);
+void initCursor(Cursor *cp, const TokenArray *ta);
+int cursorAtEnd(Cursor *cp);
+double cursorNumber(Cursor *cp);
+
+#endif
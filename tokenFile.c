@@ -0,0 +1,293 @@
+/* tokenFile.c
+ *
+ * In this file the token files of tokenFile.h are written and read. scan -w writes the token
+ * lists of an input once; recog -t and eval -t then map the file and make the token list of
+ * a line from its records, so the characters of the lines are not scanned again.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* mmap, posix_madvise, fstat */
+
+#include <stdio.h>    /* FILE, fopen, fwrite, fseek, fclose */
+#include <stdlib.h>   /* NULL, realloc, free */
+#include <string.h>   /* memcmp, memcpy, memset */
+#include <errno.h>    /* errno, EINVAL */
+#include <fcntl.h>    /* open */
+#include <unistd.h>   /* close */
+#include <sys/mman.h> /* mmap, munmap, posix_madvise */
+#include <sys/stat.h> /* fstat */
+#include <assert.h>   /* assert */
+#include "scanner.h"
+#include "input.h"
+#include "tokenFile.h"
+#include "instrument.h"
+
+/* The function padding yields the number of bytes that bring n to a multiple of 8. */
+
+static size_t padding(uint64_t n) {
+  return (size_t)(-n & 7);
+}
+
+static int writePadding(FILE *f, uint64_t n) {
+  static const char zeros[8];
+  size_t k = padding(n);
+  return fwrite(zeros, 1, k, f) == k;
+}
+
+/* A NumberPool collects the numbers of a token file while it is written. */
+
+typedef struct NumberPool {
+  TokenNumber *numbers;
+  size_t count;
+  size_t capacity;
+} NumberPool;
+
+/* The function recordOf fills the record r with the token of the node li; a number that does
+ * not fit in r is added to the pool np.
+ */
+
+static void recordOf(TokenRecord *r, List li, NumberPool *np) {
+  r->tt = (uint8_t)li->tt;
+  r->kind = (uint8_t)li->kind;
+  r->unused = 0;
+  switch (li->tt) {
+  case Number:
+    if (li->kind == NumInt) {
+      r->value = (li->t).number;
+      return;
+    }
+    if (np->count == np->capacity) {
+      np->capacity = (np->capacity == 0 ? 256 : 2 * np->capacity);
+      np->numbers = realloc(np->numbers, np->capacity * sizeof(TokenNumber));
+      assert(np->numbers != NULL);
+    }
+    if (li->kind == NumLong) {
+      np->numbers[np->count].wide = (li->t).wide;
+    } else {
+      np->numbers[np->count].decimal = (li->t).decimal;
+    }
+    r->value = (int32_t)np->count++;
+    break;
+  case Identifier:
+    r->value = li->id;
+    break;
+  case Symbol:
+    r->value = (unsigned char)(li->t).symbol;
+    break;
+  }
+}
+
+/* The function writeTokenFile scans the lines of the input in, up to a line that starts with
+ * '!' as in the batch modes, and writes their token lists to the token file at path. The
+ * identifiers get their ids from one intern table for the whole input, which becomes the
+ * identifier table. The header is written last, when the sizes of the parts are known, so the
+ * file must be a regular file. The result is 1 on success and 0 when the file cannot be written.
+ */
+
+int writeTokenFile(Input *in, const char *path) {
+  TokenFileHeader h;
+  TokenRecord r;
+  NumberPool np = {NULL, 0, 0};
+  Arena arena;
+  InternTable intern;
+  Scanner sc;
+  Line line;
+  List li;
+  uint64_t *lines;
+  size_t capacity = 1024;
+  uint32_t u;
+  int ok, i;
+  FILE *f = fopen(path, "wb");
+  if (f == NULL) {
+    return 0;
+  }
+  lines = malloc(capacity * sizeof(uint64_t));
+  assert(lines != NULL);
+  initArena(&arena);
+  initInternTable(&intern);
+  initScanner(&sc, &arena);
+  sc.views = 1;
+  sc.intern = &intern;
+  memset(&h, 0, sizeof(h));
+  ok = fwrite(&h, sizeof(h), 1, f) == 1;
+  while (ok && nextLine(in, &line) && (line.length == 0 || line.start[0] != '!')) {
+    if (h.nlines + 1 == capacity) { /* room for the end of the last line */
+      capacity = 2 * capacity;
+      lines = realloc(lines, capacity * sizeof(uint64_t));
+      assert(lines != NULL);
+    }
+    lines[h.nlines++] = h.ntokens;
+    for (li = scanLine(&sc, line.start, line.length); li != NULL && ok; li = li->next) {
+      recordOf(&r, li, &np);
+      ok = fwrite(&r, sizeof(r), 1, f) == 1;
+      h.ntokens++;
+    }
+    resetArena(&arena);
+  }
+  lines[h.nlines] = h.ntokens;
+  memcpy(h.magic, TOKENFILEMAGIC, 4);
+  h.version = TOKENFILEVERSION;
+  h.order = TOKENFILEORDER;
+  h.recordSize = sizeof(TokenRecord);
+  h.nidents = intern.count;
+  h.namesLength = intern.namesLength;
+  h.nnumbers = np.count;
+  h.numbersOffset = sizeof(h) + h.ntokens * sizeof(TokenRecord);
+  h.linesOffset = h.numbersOffset + h.nnumbers * sizeof(TokenNumber);
+  h.identsOffset = h.linesOffset + (h.nlines + 1) * sizeof(uint64_t);
+  h.namesOffset = h.identsOffset + 2 * h.nidents * sizeof(uint32_t);
+  h.namesOffset = h.namesOffset + padding(h.namesOffset);
+  ok = ok && (np.count == 0 || fwrite(np.numbers, sizeof(TokenNumber), np.count, f) == np.count) &&
+       fwrite(lines, sizeof(uint64_t), h.nlines + 1, f) == h.nlines + 1;
+  for (i = 0; ok && i < intern.count; i++) {
+    u = (uint32_t)intern.offset[i];
+    ok = fwrite(&u, sizeof(u), 1, f) == 1;
+  }
+  for (i = 0; ok && i < intern.count; i++) {
+    u = (uint32_t)intern.length[i];
+    ok = fwrite(&u, sizeof(u), 1, f) == 1;
+  }
+  ok = ok && writePadding(f, 2 * h.nidents * sizeof(uint32_t)) &&
+       (h.namesLength == 0 || fwrite(intern.names, 1, h.namesLength, f) == h.namesLength) &&
+       fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1;
+  ok = (fclose(f) == 0) && ok;
+  free(lines);
+  free(np.numbers);
+  freeArena(&arena);
+  freeInternTable(&intern);
+  return ok;
+}
+
+/* The function checkTokenFile yields whether the mapped file of tf is a token file that this
+ * machine can use: the header must match, all parts must lie within the file, and every
+ * record and line must be valid, so that tokenFileLine needs no checks of its own.
+ */
+
+static int checkTokenFile(TokenFile *tf) {
+  const TokenFileHeader *h = tf->data;
+  const TokenRecord *r;
+  uint64_t i;
+  if (tf->size < sizeof(TokenFileHeader) || memcmp(h->magic, TOKENFILEMAGIC, 4) != 0 ||
+      h->version != TOKENFILEVERSION || h->order != TOKENFILEORDER ||
+      h->recordSize != sizeof(TokenRecord)) {
+    return 0;
+  }
+  if (h->ntokens > (tf->size - sizeof(TokenFileHeader)) / sizeof(TokenRecord) ||
+      h->numbersOffset != sizeof(TokenFileHeader) + h->ntokens * sizeof(TokenRecord) ||
+      h->nnumbers > (tf->size - h->numbersOffset) / sizeof(TokenNumber) ||
+      h->linesOffset != h->numbersOffset + h->nnumbers * sizeof(TokenNumber) ||
+      h->nlines >= (tf->size - h->linesOffset) / sizeof(uint64_t) ||
+      h->identsOffset != h->linesOffset + (h->nlines + 1) * sizeof(uint64_t) ||
+      h->nidents > (tf->size - h->identsOffset) / (2 * sizeof(uint32_t)) ||
+      h->namesOffset < h->identsOffset + 2 * h->nidents * sizeof(uint32_t) ||
+      h->namesOffset > tf->size || h->namesLength > tf->size - h->namesOffset ||
+      h->namesOffset % 8 != 0) {
+    return 0;
+  }
+  tf->header = h;
+  tf->records = (const TokenRecord *)(h + 1);
+  tf->numbers = (const TokenNumber *)((char *)tf->data + h->numbersOffset);
+  tf->lines = (const uint64_t *)((char *)tf->data + h->linesOffset);
+  tf->offset = (const uint32_t *)((char *)tf->data + h->identsOffset);
+  tf->length = tf->offset + h->nidents;
+  tf->names = (const char *)tf->data + h->namesOffset;
+  tf->nlines = h->nlines;
+  for (i = 0; i < h->ntokens; i++) {
+    r = &tf->records[i];
+    if (r->tt > Symbol || r->kind > NumDecimal ||
+        (r->tt == Identifier && (r->value < 0 || (uint64_t)r->value >= h->nidents)) ||
+        (r->tt == Number && r->kind != NumInt &&
+         (r->value < 0 || (uint64_t)r->value >= h->nnumbers))) {
+      return 0;
+    }
+  }
+  for (i = 0; i < h->nidents; i++) {
+    if (tf->offset[i] > h->namesLength || tf->length[i] > h->namesLength - tf->offset[i]) {
+      return 0;
+    }
+  }
+  for (i = 0; i < h->nlines; i++) {
+    if (tf->lines[i] > tf->lines[i + 1]) {
+      return 0;
+    }
+  }
+  return tf->lines[0] == 0 && tf->lines[h->nlines] == h->ntokens;
+}
+
+/* The function openTokenFile maps the token file at path in memory. It yields 1 on success,
+ * and 0 when the file cannot be opened, with errno set, or is no token file for this
+ * machine, with errno set to EINVAL.
+ */
+
+int openTokenFile(TokenFile *tf, const char *path) {
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  tf->data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    tf->size = st.st_size;
+    tf->data = mmap(NULL, tf->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (tf->data == MAP_FAILED) {
+    errno = EINVAL;
+    return 0;
+  }
+  posix_madvise(tf->data, tf->size, POSIX_MADV_SEQUENTIAL);
+  if (!checkTokenFile(tf)) {
+    munmap(tf->data, tf->size);
+    errno = EINVAL;
+    return 0;
+  }
+  return 1;
+}
+
+/* The function tokenFileLine makes the token list of line i from its records, with the nodes
+ * in the arena a. The identifiers point into the names of the mapped file, as with a Scanner
+ * with views, and have the ids of the identifier table; the list lives until a is reset or
+ * the file is closed.
+ */
+
+List tokenFileLine(const TokenFile *tf, size_t i, Arena *a) {
+  const TokenRecord *r = tf->records + tf->lines[i];
+  const TokenRecord *end = tf->records + tf->lines[i + 1];
+  List tl = NULL;
+  List *tp = &tl;
+  List node;
+  for (; r < end; r++) {
+    node = arenaAlloc(a, sizeof(struct ListNode));
+    COUNT(CountNodes, 1);
+    node->tt = (TokenType)r->tt;
+    node->kind = (NumberKind)r->kind;
+    node->length = 0;
+    node->id = -1;
+    switch (node->tt) {
+    case Number:
+      if (node->kind == NumInt) {
+        (node->t).number = r->value;
+      } else if (node->kind == NumLong) {
+        (node->t).wide = tf->numbers[r->value].wide;
+      } else {
+        (node->t).decimal = tf->numbers[r->value].decimal;
+      }
+      break;
+    case Identifier:
+      node->id = r->value;
+      node->length = tf->length[r->value];
+      (node->t).identifier = (char *)tf->names + tf->offset[r->value];
+      break;
+    case Symbol:
+      (node->t).symbol = (char)r->value;
+      break;
+    }
+    *tp = node;
+    tp = &node->next;
+  }
+  *tp = NULL;
+  return tl;
+}
+
+void closeTokenFile(TokenFile *tf) {
+  munmap(tf->data, tf->size);
+}
@@ -0,0 +1,82 @@
+/* tokenFile.h, binary files of scanned lines that are used without scanning them again */
+
+#ifndef TOKENFILE_H
+#define TOKENFILE_H
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint8_t, uint32_t, int32_t, uint64_t */
+#include "scanner.h"
+#include "input.h"
+
+#define TOKENFILEMAGIC "EQTK"
+#define TOKENFILEVERSION 1
+#define TOKENFILEORDER 0x01020304u /* tells whether the file has the byte order of this machine */
+
+/* A token file holds the token lists of the lines of an input, in the byte order of the machine
+ * that wrote it. It consists of, in this order:
+ * the header;
+ * ntokens token records, the tokens of all lines one after the other;
+ * the numbers at numbersOffset: nnumbers numbers that do not fit in a token record;
+ * the line table at linesOffset: nlines + 1 numbers, where the tokens of line i are the
+ * records lines[i] up to lines[i+1];
+ * the identifier table at identsOffset: the offsets in names of nidents identifiers, followed
+ * by their lengths, both as uint32_t;
+ * the names at namesOffset, namesLength characters, each name terminated by '\0'.
+ * All parts start at a multiple of 8, so the file can be used in place when it is mapped.
+ */
+
+typedef struct TokenFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t order;
+  uint32_t recordSize;
+  uint64_t nlines;
+  uint64_t ntokens;
+  uint64_t nidents;
+  uint64_t namesLength;
+  uint64_t nnumbers;
+  uint64_t numbersOffset;
+  uint64_t linesOffset;
+  uint64_t identsOffset;
+  uint64_t namesOffset;
+} TokenFileHeader;
+
+/* A token record is a token of fixed width, as in a token array (see tokenArray.h): tt is its
+ * TokenType and kind its NumberKind. value is the number of a NumInt, the character of a
+ * symbol, or the id of an identifier in the identifier table; for a NumLong or NumDecimal it is
+ * the index of the number in the numbers of the file.
+ */
+
+typedef struct TokenRecord {
+  uint8_t tt;
+  uint8_t kind;
+  uint16_t unused;
+  int32_t value;
+} TokenRecord;
+
+typedef union TokenNumber {
+  int64_t wide;
+  double decimal;
+} TokenNumber;
+
+/* A TokenFile is a token file that is mapped in memory; its parts point into the mapping. */
+
+typedef struct TokenFile {
+  void *data;
+  size_t size;
+  const TokenFileHeader *header;
+  const TokenRecord *records;
+  const TokenNumber *numbers;
+  const uint64_t *lines;
+  const uint32_t *offset;
+  const uint32_t *length;
+  const char *names;
+  size_t nlines;
+} TokenFile;
+
+int writeTokenFile(Input *in, const char *path);
+int openTokenFile(TokenFile *tf, const char *path);
+List tokenFileLine(const TokenFile *tf, size_t i, Arena *a);
+void closeTokenFile(TokenFile *tf);
+
+#endif
@@ -0,0 +1,197 @@
+/* writer.c
+ *
+ * In this file the writer of writer.h is defined. Integers and numbers with a fixed number of
+ * decimals, which make up most of the output of recog, are formatted here by hand, directly
+ * into the buffer; only the rare cases in which that cannot give the same digits as printf
+ * are left to snprintf.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* write */
+
+#include <stdio.h>  /* snprintf */
+#include <stdlib.h> /* malloc, free */
+#include <string.h> /* memcpy, strlen */
+#include <math.h>   /* floor, fabs */
+#include <errno.h>  /* errno, EINTR */
+#include <unistd.h> /* write */
+#include <assert.h> /* assert */
+#include "scanner.h"
+#include "writer.h"
+
+void initWriter(Writer *w, int fd) {
+  w->fd = fd;
+  w->capacity = WRITERBLOCK;
+  w->buf = malloc(w->capacity);
+  assert(w->buf != NULL);
+  w->length = 0;
+  w->flushes = 0;
+  w->failed = 0;
+}
+
+/* The function writeAll writes s[0..n-1] to the file descriptor, with as many writes as it
+ * takes.
+ */
+
+static void writeAll(Writer *w, const char *s, size_t n) {
+  ssize_t k;
+  while (n > 0 && !w->failed) {
+    k = write(w->fd, s, n);
+    if (k < 0 && errno != EINTR) {
+      w->failed = 1;
+    } else if (k > 0) {
+      s = s + k;
+      n = n - k;
+    }
+  }
+}
+
+/* The function flushWriter writes the buffer out. It yields 0 when a write has failed, now or
+ * before.
+ */
+
+int flushWriter(Writer *w) {
+  writeAll(w, w->buf, w->length);
+  w->length = 0;
+  w->flushes++;
+  return !w->failed;
+}
+
+/* The function freeWriter flushes the buffer and frees it. It yields what flushWriter yields:
+ * 0 when a write has failed.
+ */
+
+int freeWriter(Writer *w) {
+  int ok = flushWriter(w);
+  free(w->buf);
+  w->buf = NULL;
+  return ok;
+}
+
+/* The function room makes sure that n more bytes fit in the buffer, which may flush it. */
+
+static void room(Writer *w, size_t n) {
+  if (w->length + n > w->capacity) {
+    flushWriter(w);
+  }
+}
+
+void writeBytes(Writer *w, const char *s, size_t n) {
+  if (n > w->capacity) { /* too big for the buffer: it goes out at once */
+    flushWriter(w);
+    writeAll(w, s, n);
+    return;
+  }
+  room(w, n);
+  memcpy(w->buf + w->length, s, n);
+  w->length = w->length + n;
+}
+
+void writeString(Writer *w, const char *s) {
+  writeBytes(w, s, strlen(s));
+}
+
+void writeChar(Writer *w, char c) {
+  room(w, 1);
+  w->buf[w->length++] = c;
+}
+
+/* The function writeInt writes n as printf("%lld") does: the digits are made from the end,
+ * in an unsigned number, so that LLONG_MIN can be negated too.
+ */
+
+void writeInt(Writer *w, long long n) {
+  char digits[24];
+  int i = sizeof(digits);
+  unsigned long long u = (n < 0 ? 0ULL - (unsigned long long)n : (unsigned long long)n);
+  do {
+    digits[--i] = (char)('0' + u % 10);
+    u = u / 10;
+  } while (u != 0);
+  if (n < 0) {
+    digits[--i] = '-';
+  }
+  writeBytes(w, digits + i, sizeof(digits) - i);
+}
+
+/* The function writeFixed writes x as printf("%.*f", decimals, x) does, for at most 9
+ * decimals. x is scaled to an integer number of units of the last decimal and rounded; when
+ * the scaled value is so close to halfway between two units that the rounding error of the
+ * scaling could matter, or too big for a long long, snprintf decides.
+ */
+
+void writeFixed(Writer *w, double x, int decimals) {
+  static const double powers[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+  char s[64];
+  long long units, whole;
+  double y, r;
+  int i, n;
+  assert(decimals >= 0 && decimals <= 9);
+  y = fabs(x) * powers[decimals];
+  r = floor(y + 0.5);
+  if (!(y < 1e15) || fabs(y - floor(y) - 0.5) < 1e-6) {
+    n = snprintf(s, sizeof(s), "%.*f", decimals, x);
+    writeBytes(w, s, n < (int)sizeof(s) ? n : (int)sizeof(s) - 1);
+    return;
+  }
+  units = (long long)r;
+  whole = units / (long long)powers[decimals];
+  if (x < 0 || (x == 0 && 1 / x < 0)) { /* printf keeps the sign of -0.0 and of -0.0001 */
+    writeChar(w, '-');
+  }
+  writeInt(w, whole);
+  if (decimals > 0) {
+    units = units - whole * (long long)powers[decimals];
+    s[0] = '.';
+    for (i = decimals; i > 0; i--) {
+      s[i] = (char)('0' + units % 10);
+      units = units / 10;
+    }
+    writeBytes(w, s, decimals + 1);
+  }
+}
+
+/* The function writeDecimal writes x as fprintDecimal in scanner.c does, with the fewest of
+ * 15, 16 and 17 significant digits that give back x.
+ */
+
+void writeDecimal(Writer *w, double x) {
+  char s[32];
+  int digits = 15;
+  int n = snprintf(s, sizeof(s), "%.15g", x);
+  while (digits < 17 && strtod(s, NULL) != x) {
+    digits++;
+    n = snprintf(s, sizeof(s), "%.*g", digits, x);
+  }
+  writeBytes(w, s, n);
+}
+
+/* The function writeTokens writes the tokens of tl as fprintList does, with the characters of
+ * a NumDecimal number when they are known.
+ */
+
+void writeTokens(Writer *w, List tl) {
+  while (tl != NULL) {
+    switch (tl->tt) {
+    case Number:
+      if (tl->kind == NumInt) {
+        writeInt(w, (tl->t).number);
+      } else if (tl->kind == NumLong) {
+        writeInt(w, (tl->t).wide);
+      } else if (numberLiteral(tl) != NULL) {
+        writeBytes(w, numberLiteral(tl), tl->length);
+      } else {
+        writeDecimal(w, (tl->t).decimal);
+      }
+      break;
+    case Identifier:
+      writeBytes(w, (tl->t).identifier, tl->length);
+      break;
+    case Symbol:
+      writeChar(w, (tl->t).symbol);
+      break;
+    }
+    writeChar(w, ' ');
+    tl = tl->next;
+  }
+  writeChar(w, '\n');
+}
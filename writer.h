@@ -0,0 +1,48 @@
+/* writer.h, buffered output with formatting of its own */
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stddef.h> /* size_t */
+#include "scanner.h"
+
+#define WRITERBLOCK (1 << 20) /* size of the buffer of a writer */
+
+/* The formats of the batch output of recog: the text of the dialogue, or one record per line,
+ * as tab separated values or as a JSON object, see recognizeBatch.
+ */
+
+typedef enum OutputFormat {
+  FormatText,
+  FormatTsv,
+  FormatJson
+} OutputFormat;
+
+/* A Writer collects output in the buffer buf, which holds length of its capacity bytes, and
+ * writes it to the file descriptor fd with write when it is full, so a line of output costs no
+ * system call and no call of printf. flushes counts the flushes, so that a caller can tell
+ * whether what it wrote since some point is still in buf. failed is set when a write fails;
+ * the output is then discarded.
+ */
+
+typedef struct Writer {
+  int fd;
+  char *buf;
+  size_t length;
+  size_t capacity;
+  long flushes;
+  int failed;
+} Writer;
+
+void initWriter(Writer *w, int fd);
+int flushWriter(Writer *w);
+int freeWriter(Writer *w);
+void writeBytes(Writer *w, const char *s, size_t n);
+void writeString(Writer *w, const char *s);
+void writeChar(Writer *w, char c);
+void writeInt(Writer *w, long long n);
+void writeFixed(Writer *w, double x, int decimals);
+void writeDecimal(Writer *w, double x);
+void writeTokens(Writer *w, List tl);
+
+#endif